@@ -0,0 +1,63 @@
+// The C interface in ArcadeEnv.h, a thin wrapper around BatchEnv
+#define ARCADE_ENV_BUILD
+#include "ArcadeEnv.h"
+#include "BatchEnv.hpp"
+
+// Matches ArcadeEnv.h's constants to the simulation's so actions pass straight through
+static_assert(ARCADE_ACTION_UP == INPUT_UP && ARCADE_ACTION_DOWN == INPUT_DOWN && ARCADE_ACTION_LEFT == INPUT_LEFT &&
+    ARCADE_ACTION_RIGHT == INPUT_RIGHT && ARCADE_ACTION_FLAP == INPUT_FLAP, "action bits out of step with InputBits");
+static_assert(ARCADE_ENV_SNAKE == GAME_SNAKE && ARCADE_ENV_FLAPPY == GAME_FLAPPY, "games out of step with GameKind");
+
+struct ArcadeEnv {
+    BatchEnv batch;
+
+    ArcadeEnv(GameKind game, size_t count, int threads, int ticksPerSecond) : batch(game, count, threads, ticksPerSecond) {}
+};
+
+extern "C" {
+
+ArcadeEnv* arcade_env_create(int game, size_t count, int threads, int ticks_per_second) {
+    if (game != GAME_SNAKE && game != GAME_FLAPPY) return nullptr;
+    if (ticks_per_second <= 0) ticks_per_second = SIM_TICKS_PER_SECOND;
+    // nothing may throw across the C boundary, and building the batch can run out of memory or threads
+    try {
+        return new ArcadeEnv(static_cast<GameKind>(game), count, threads, ticks_per_second);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void arcade_env_destroy(ArcadeEnv* env) {
+    delete env;
+}
+
+size_t arcade_env_size(const ArcadeEnv* env) {
+    return env->batch.size();
+}
+
+size_t arcade_env_observation_size(const ArcadeEnv* env) {
+    return env->batch.observationSize();
+}
+
+int arcade_env_board_width(const ArcadeEnv* env) {
+    return env->batch.getGame() == GAME_SNAKE ? SNAKE_COLS : WINDOW_WIDTH;
+}
+
+int arcade_env_board_height(const ArcadeEnv* env) {
+    return env->batch.getGame() == GAME_SNAKE ? SNAKE_ROWS : WINDOW_HEIGHT;
+}
+
+void arcade_env_reset(ArcadeEnv* env, size_t index, uint64_t seed) {
+    env->batch.reset(index, seed);
+}
+
+void arcade_env_observe(ArcadeEnv* env, float* observations) {
+    env->batch.observe(observations);
+}
+
+void arcade_env_step(ArcadeEnv* env, const uint8_t* actions, float* observations, float* rewards, uint8_t* dones) {
+    env->batch.step(actions, observations, rewards, dones);
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+/* C interface to BatchEnv, for embedding the games as training environments from C, Python
+ * (ctypes/cffi) or anything else with a C FFI. Build it as a library on its own, it doesn't need
+ * SFML or a window:
+ *   g++ -std=c++17 -O2 -shared -fPIC -pthread code/ArcadeEnv.cpp -o libarcadeenv.so
+ * Every buffer is owned by the caller and written in place; stepping never allocates. */
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(ARCADE_ENV_BUILD)
+#define ARCADE_ENV_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define ARCADE_ENV_API __declspec(dllimport)
+#else
+#define ARCADE_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Games */
+#define ARCADE_ENV_SNAKE 1
+#define ARCADE_ENV_FLAPPY 2
+
+/* Action bits, one byte per environment per step. Snake steers with the arrows, flappy flaps. */
+#define ARCADE_ACTION_NONE 0
+#define ARCADE_ACTION_UP 1
+#define ARCADE_ACTION_DOWN 2
+#define ARCADE_ACTION_LEFT 4
+#define ARCADE_ACTION_RIGHT 8
+#define ARCADE_ACTION_FLAP 16
+
+typedef struct ArcadeEnv ArcadeEnv;
+
+/* count rounds of game, seeded 0..count-1, stepped across up to threads threads. ticks_per_second
+ * of 0 means the game's default of 60. NULL for an unknown game, or if memory or threads ran out. */
+ARCADE_ENV_API ArcadeEnv* arcade_env_create(int game, size_t count, int threads, int ticks_per_second);
+ARCADE_ENV_API void arcade_env_destroy(ArcadeEnv* env);
+
+ARCADE_ENV_API size_t arcade_env_size(const ArcadeEnv* env);
+/* Floats per round in an observation.
+ * Snake: one per board cell row by row (0 empty, 1 body, 2 head, 3 food), then the heading (0 right, 1 down, 2 left, 3 up).
+ * Flappy: bird y, velocity, rotation, next pipe x, gap top, gap bottom, in pixels. */
+ARCADE_ENV_API size_t arcade_env_observation_size(const ArcadeEnv* env);
+ARCADE_ENV_API int arcade_env_board_width(const ArcadeEnv* env);
+ARCADE_ENV_API int arcade_env_board_height(const ArcadeEnv* env);
+
+/* Starts round index over. The same seed and actions always play out the same way. */
+ARCADE_ENV_API void arcade_env_reset(ArcadeEnv* env, size_t index, uint64_t seed);
+/* Writes every round's current observation, size * observation_size floats. */
+ARCADE_ENV_API void arcade_env_observe(ArcadeEnv* env, float* observations);
+/* Advances every round one tick. actions: one byte per round. observations: size * observation_size
+ * floats, rewards: points scored this tick, dones: 1 once the round is over, one per round.
+ * Outputs may be NULL. A finished round ignores its actions until it is reset.
+ * Stepping into the same observations buffer as last time only rewrites the snake boards that
+ * changed. Do not modify that buffer between steps (normalising or frame-stacking in place), or
+ * call arcade_env_observe on it after doing so; otherwise unchanged boards are left as you edited them. */
+ARCADE_ENV_API void arcade_env_step(ArcadeEnv* env, const uint8_t* actions, float* observations, float* rewards, uint8_t* dones);
+
+#ifdef __cplusplus
+}
+#endif
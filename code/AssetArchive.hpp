@@ -0,0 +1,213 @@
+#pragma once
+// Packed asset archive: every asset in one file with an index up front. At runtime the whole file
+// is memory-mapped once and assets are handed to SFML's loadFromMemory straight out of the
+// mapping, so there is one open at startup and no per-asset read into a buffer.
+#include <string>
+#include <map>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <iostream>
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Archive layout, little-endian:
+//   "APAK" u32 version, u32 entryCount,
+//   then per entry: u16 nameLength, name (relative path with '/' separators), u64 offset, u64 size,
+//   then the file contents, each starting on a 16 byte boundary
+const uint32_t ASSET_ARCHIVE_VERSION = 1;
+const uint64_t ASSET_ARCHIVE_ALIGNMENT = 16;
+
+class AssetArchive {
+public:
+    struct Entry {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+private:
+    std::map<std::string, Entry> index;
+    const uint8_t* base;
+    size_t mappedSize;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+
+    static void putLE(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    static uint64_t getLE(const uint8_t* in, int bytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+        return value;
+    }
+
+    bool map(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) return false;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) return false;
+        base = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        mappedSize = static_cast<size_t>(size.QuadPart);
+        return base != nullptr;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps the file alive
+        if (view == MAP_FAILED) return false;
+        base = static_cast<const uint8_t*>(view);
+        mappedSize = static_cast<size_t>(info.st_size);
+        return true;
+#endif
+    }
+
+    //reads the index, false if the file isn't a well-formed archive
+    bool readIndex() {
+        if (mappedSize < 12 || std::memcmp(base, "APAK", 4) != 0 || getLE(base + 4, 4) != ASSET_ARCHIVE_VERSION) return false;
+        uint32_t count = static_cast<uint32_t>(getLE(base + 8, 4));
+        size_t position = 12;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (position + 2 > mappedSize) return false;
+            size_t nameLength = static_cast<size_t>(getLE(base + position, 2));
+            position += 2;
+            if (position + nameLength + 16 > mappedSize) return false;
+            std::string name(reinterpret_cast<const char*>(base + position), nameLength);
+            position += nameLength;
+            Entry entry = { getLE(base + position, 8), getLE(base + position + 8, 8) };
+            position += 16;
+            if (entry.offset > mappedSize || entry.size > mappedSize - entry.offset) return false;
+            index[name] = entry;
+        }
+        return true;
+    }
+
+public:
+    AssetArchive() : base(nullptr), mappedSize(0)
+#ifdef _WIN32
+        , file(INVALID_HANDLE_VALUE), mapping(nullptr)
+#endif
+    {}
+
+    ~AssetArchive() { close(); }
+
+    AssetArchive(const AssetArchive&) = delete;
+    AssetArchive& operator=(const AssetArchive&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+        if (map(path) && readIndex()) return true;
+        close();
+        return false;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (base) UnmapViewOfFile(base);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (base) munmap(const_cast<uint8_t*>(base), mappedSize);
+#endif
+        base = nullptr;
+        mappedSize = 0;
+        index.clear();
+    }
+
+    bool isOpen() const { return base != nullptr; }
+
+    const Entry* find(const std::string& name) const {
+        auto found = index.find(name);
+        return found == index.end() ? nullptr : &found->second;
+    }
+
+    //points into the mapping, valid for as long as the archive stays open
+    const void* data(const Entry& entry) const { return base + entry.offset; }
+
+    size_t getEntryCount() const { return index.size(); }
+    size_t getMappedSize() const { return mappedSize; }
+
+    //packs every file under dir into an archive at outPath, returns how many files went in or -1
+    static int pack(const std::string& dir, const std::string& outPath) {
+        namespace fs = std::filesystem;
+        std::error_code error;
+        std::vector<fs::path> files;
+        for (fs::recursive_directory_iterator it(dir, error), end; !error && it != end; it.increment(error)) {
+            // an old archive being rebuilt in place doesn't pack itself
+            if (it->is_regular_file() && !(fs::exists(outPath) && fs::equivalent(it->path(), outPath))) files.push_back(it->path());
+        }
+        if (error) {
+            std::cerr << "Failed to read asset directory: " << dir << std::endl;
+            return -1;
+        }
+        std::sort(files.begin(), files.end()); // same input, byte-identical archive
+
+        std::vector<std::string> names;
+        size_t indexSize = 12;
+        for (const auto& file : files) {
+            names.push_back(fs::relative(file, dir).generic_string());
+            indexSize += 2 + names.back().size() + 16;
+        }
+
+        std::vector<std::vector<char>> contents;
+        std::vector<uint8_t> header = { 'A', 'P', 'A', 'K' };
+        putLE(header, ASSET_ARCHIVE_VERSION, 4);
+        putLE(header, files.size(), 4);
+        uint64_t offset = indexSize;
+        for (size_t i = 0; i < files.size(); ++i) {
+            std::ifstream in(files[i], std::ios::binary);
+            if (!in.is_open()) {
+                std::cerr << "Failed to read asset: " << files[i].string() << std::endl;
+                return -1;
+            }
+            contents.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            offset = (offset + ASSET_ARCHIVE_ALIGNMENT - 1) / ASSET_ARCHIVE_ALIGNMENT * ASSET_ARCHIVE_ALIGNMENT;
+            putLE(header, names[i].size(), 2);
+            header.insert(header.end(), names[i].begin(), names[i].end());
+            putLE(header, offset, 8);
+            putLE(header, contents.back().size(), 8);
+            offset += contents.back().size();
+        }
+
+        std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Failed to write archive: " << outPath << std::endl;
+            return -1;
+        }
+        out.write(reinterpret_cast<const char*>(header.data()), header.size());
+        uint64_t written = header.size();
+        for (const auto& content : contents) {
+            static const char padding[ASSET_ARCHIVE_ALIGNMENT] = {};
+            uint64_t aligned = (written + ASSET_ARCHIVE_ALIGNMENT - 1) / ASSET_ARCHIVE_ALIGNMENT * ASSET_ARCHIVE_ALIGNMENT;
+            out.write(padding, static_cast<std::streamsize>(aligned - written));
+            out.write(content.data(), static_cast<std::streamsize>(content.size()));
+            written = aligned + content.size();
+        }
+        return out ? static_cast<int>(files.size()) : -1;
+    }
+};
@@ -0,0 +1,235 @@
+#pragma once
+// The games as training environments: a batch of independent snake or flappy rounds stepped
+// together, optionally split across threads, writing observations, rewards and done flags
+// straight into buffers the caller owns. Nothing here allocates once the batch is built.
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdint>
+#include "Simulation.hpp"
+#include "Replay.hpp"
+#include "FlappyBatch.hpp"
+
+// Snake observations: one float per board cell, row by row, then the heading (SnakeDirection)
+const float SNAKE_OBSERVE_EMPTY = 0.f;
+const float SNAKE_OBSERVE_BODY = 1.f;
+const float SNAKE_OBSERVE_HEAD = 2.f;
+const float SNAKE_OBSERVE_FOOD = 3.f;
+const size_t SNAKE_OBSERVATION_SIZE = SnakeBoard::CELLS + 1;
+
+// Flappy observations: bird y, velocity and rotation, then the next pipe's x, gap top and gap
+// bottom (x is WINDOW_WIDTH and the gap the whole screen when no pipe is coming)
+const size_t FLAPPY_OBSERVATION_SIZE = 6;
+
+class BatchEnv {
+private:
+    // A contiguous run of environments one thread steps
+    struct Shard {
+        size_t begin;
+        size_t end;
+        std::vector<SnakeSim> snakes;
+        std::unique_ptr<FlappyBatch> flappy;
+        std::vector<uint8_t> events; // flappy's per-world events, kept so stepping doesn't allocate
+        std::vector<int> lastScore;
+        std::vector<uint32_t> observedVersion; // snake body last written to the observation buffer
+        const float* observedBuffer; // ...and which buffer it went to
+    };
+
+    GameKind game;
+    size_t count;
+    std::vector<Shard> shards;
+
+    // Threads 1..n-1 each step one shard, the calling thread steps shard 0
+    std::vector<std::thread> workers;
+    std::mutex stepMutex;
+    std::condition_variable stepReady;
+    std::condition_variable stepDone;
+    uint64_t generation;
+    size_t remaining;
+    bool stopping;
+    const uint8_t* stepActions;
+    float* stepObservations;
+    float* stepRewards;
+    uint8_t* stepDones;
+
+    void workerLoop(size_t shard) {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(stepMutex);
+                stepReady.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            stepShard(shards[shard], stepActions, stepObservations, stepRewards, stepDones);
+            std::lock_guard<std::mutex> lock(stepMutex);
+            if (--remaining == 0) stepDone.notify_one();
+        }
+    }
+
+    //the grid only changes when the snake moves, every few ticks, so it's only rewritten then
+    //or when it's going into a different buffer
+    void observeSnake(Shard& shard, size_t env, float* out, bool sameBuffer) {
+        const SnakeSim& sim = shard.snakes[env - shard.begin];
+        uint32_t& version = shard.observedVersion[env - shard.begin];
+        out[SnakeBoard::CELLS] = static_cast<float>(sim.direction);
+        if (sameBuffer && version == sim.bodyVersion) return;
+        version = sim.bodyVersion;
+
+        for (int cell = 0; cell < SnakeBoard::CELLS; ++cell) {
+            out[cell] = sim.board.segments[cell] ? SNAKE_OBSERVE_BODY : SNAKE_OBSERVE_EMPTY;
+        }
+        const SnakeCell& head = sim.segment(0);
+        if (SnakeBoard::inBounds(head.x, head.y)) out[SnakeBoard::index(head.x, head.y)] = SNAKE_OBSERVE_HEAD;
+        if (sim.foodX >= 0) out[SnakeBoard::index(sim.foodX, sim.foodY)] = SNAKE_OBSERVE_FOOD;
+    }
+
+    void observeFlappy(const Shard& shard, size_t env, float* out) const {
+        const FlappyBatch& batch = *shard.flappy;
+        size_t world = env - shard.begin;
+        out[0] = batch.getBirdY(world);
+        out[1] = batch.getBirdVelocity(world);
+        out[2] = batch.getBirdRotation(world);
+        if (!batch.nextPipe(world, out[3], out[4], out[5])) {
+            out[3] = static_cast<float>(WINDOW_WIDTH);
+            out[4] = 0.f;
+            out[5] = static_cast<float>(WINDOW_HEIGHT);
+        }
+    }
+
+    void observeShard(Shard& shard, float* observations) {
+        size_t size = observationSize();
+        bool sameBuffer = shard.observedBuffer == observations;
+        for (size_t env = shard.begin; env < shard.end; ++env) {
+            if (game == GAME_SNAKE) observeSnake(shard, env, observations + env * size, sameBuffer);
+            else observeFlappy(shard, env, observations + env * size);
+        }
+        if (game == GAME_SNAKE) shard.observedBuffer = observations;
+    }
+
+    void stopWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(stepMutex);
+            stopping = true;
+        }
+        stepReady.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    void stepShard(Shard& shard, const uint8_t* actions, float* observations, float* rewards, uint8_t* dones) {
+        if (game == GAME_SNAKE) {
+            for (size_t env = shard.begin; env < shard.end; ++env) {
+                shard.snakes[env - shard.begin].step(actions[env]);
+            }
+        }
+        else {
+            shard.flappy->step(actions + shard.begin, shard.events.data());
+        }
+
+        for (size_t env = shard.begin; env < shard.end; ++env) {
+            size_t local = env - shard.begin;
+            int score = game == GAME_SNAKE ? shard.snakes[local].score : shard.flappy->getScore(local);
+            if (rewards) rewards[env] = static_cast<float>(score - shard.lastScore[local]);
+            if (dones) dones[env] = game == GAME_SNAKE ? shard.snakes[local].gameOver : shard.flappy->isGameOver(local);
+            shard.lastScore[local] = score;
+        }
+        if (observations) observeShard(shard, observations);
+    }
+
+public:
+    //envs rounds of game, seeded 0..envs-1 until reset, stepped on up to threads threads
+    BatchEnv(GameKind kind, size_t envs, int threads = 1, int ticksPerSecond = SIM_TICKS_PER_SECOND)
+        : game(kind), count(envs), generation(0), remaining(0), stopping(false),
+        stepActions(nullptr), stepObservations(nullptr), stepRewards(nullptr), stepDones(nullptr) {
+        size_t shardCount = std::max<size_t>(1, std::min<size_t>(static_cast<size_t>(std::max(threads, 1)), envs));
+        // flappy shards start on a lane boundary so every batch but the last is whole lanes
+        size_t per = (envs + shardCount - 1) / shardCount;
+        per = (per + BatchLanes::WIDTH - 1) / BatchLanes::WIDTH * BatchLanes::WIDTH;
+        for (size_t begin = 0; begin < envs || shards.empty(); begin += per) {
+            Shard shard;
+            shard.begin = begin;
+            shard.end = std::min(begin + per, envs);
+            size_t size = shard.end - shard.begin;
+            if (game == GAME_SNAKE) {
+                shard.snakes.reserve(size);
+                for (size_t env = shard.begin; env < shard.end; ++env) shard.snakes.emplace_back(env, ticksPerSecond);
+            }
+            else {
+                shard.flappy = std::make_unique<FlappyBatch>(size, ticksPerSecond);
+                for (size_t env = shard.begin; env < shard.end; ++env) shard.flappy->reset(env - shard.begin, env);
+            }
+            shard.events.resize(size);
+            shard.lastScore.assign(size, 0);
+            shard.observedVersion.assign(size, 0);
+            shard.observedBuffer = nullptr;
+            shards.push_back(std::move(shard));
+        }
+        try {
+            for (size_t shard = 1; shard < shards.size(); ++shard) {
+                workers.emplace_back(&BatchEnv::workerLoop, this, shard);
+            }
+        }
+        catch (...) {
+            // the destructor won't run for a half-built batch, and a joinable thread left behind terminates
+            stopWorkers();
+            throw;
+        }
+    }
+
+    ~BatchEnv() { stopWorkers(); }
+
+    BatchEnv(const BatchEnv&) = delete;
+    BatchEnv& operator=(const BatchEnv&) = delete;
+
+    size_t size() const { return count; }
+    size_t getThreadCount() const { return shards.size(); }
+    GameKind getGame() const { return game; }
+    size_t observationSize() const { return game == GAME_SNAKE ? SNAKE_OBSERVATION_SIZE : FLAPPY_OBSERVATION_SIZE; }
+
+    //starts one round over, the same seed always plays out the same way for the same actions
+    void reset(size_t env, uint64_t seed) {
+        for (auto& shard : shards) {
+            if (env < shard.begin || env >= shard.end) continue;
+            size_t local = env - shard.begin;
+            if (game == GAME_SNAKE) shard.snakes[local].reset(seed);
+            else shard.flappy->reset(local, seed);
+            shard.lastScore[local] = 0; // a reset snake has a new bodyVersion, so its grid is written out again
+        }
+    }
+
+    //writes every round's current observation, e.g. after resetting
+    void observe(float* observations) {
+        for (auto& shard : shards) {
+            shard.observedBuffer = nullptr;
+            observeShard(shard, observations);
+        }
+    }
+
+    //advances every round one tick. actions holds one InputBits per round, observations
+    //size() * observationSize() floats, rewards (points scored this tick) and dones (round over)
+    //one entry per round. Any output can be null. Finished rounds stay finished until reset.
+    //A snake's grid is only rewritten when it moved or the buffer differs from the last step's, so
+    //a caller that edits the observations in place has to observe() into them again afterwards.
+    void step(const uint8_t* actions, float* observations, float* rewards, uint8_t* dones) {
+        if (workers.empty()) {
+            stepShard(shards[0], actions, observations, rewards, dones);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(stepMutex);
+            stepActions = actions;
+            stepObservations = observations;
+            stepRewards = rewards;
+            stepDones = dones;
+            remaining = workers.size();
+            generation++;
+        }
+        stepReady.notify_all();
+        stepShard(shards[0], actions, observations, rewards, dones);
+        std::unique_lock<std::mutex> lock(stepMutex);
+        stepDone.wait(lock, [this] { return remaining == 0; });
+    }
+};
@@ -0,0 +1,445 @@
+#pragma once
+// Thousands of independent flappy worlds stepped together, for bots and training. Each field of
+// every world lives in its own array (structure of arrays), so gravity, collision and scoring run
+// several worlds per instruction: 8 with AVX, 4 with SSE2, one at a time otherwise. Every world
+// follows FlappySim's rules exactly, the same seed and inputs give bit-identical state.
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include "Simulation.hpp"
+
+// Build with -mavx for the 8-wide path, define FLAPPY_BATCH_SCALAR to force the plain one
+#if !defined(FLAPPY_BATCH_SCALAR) && defined(__AVX__)
+#include <immintrin.h>
+#define FLAPPY_BATCH_AVX
+#elif !defined(FLAPPY_BATCH_SCALAR) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define FLAPPY_BATCH_SSE2
+#endif
+
+// The handful of lane operations the kernels need. A Mask lane is all ones or all zeros.
+#if defined(FLAPPY_BATCH_AVX)
+struct BatchLanes {
+    static const int WIDTH = 8;
+    typedef __m256 Floats;
+    typedef __m256 Mask;
+    static const char* name() { return "avx"; }
+    static Floats load(const float* in) { return _mm256_loadu_ps(in); }
+    static void store(float* out, Floats value) { _mm256_storeu_ps(out, value); }
+    static Floats splat(float value) { return _mm256_set1_ps(value); }
+    static Floats add(Floats a, Floats b) { return _mm256_add_ps(a, b); }
+    static Floats sub(Floats a, Floats b) { return _mm256_sub_ps(a, b); }
+    static Floats min(Floats a, Floats b) { return _mm256_min_ps(a, b); }
+    static Floats max(Floats a, Floats b) { return _mm256_max_ps(a, b); }
+    static Mask less(Floats a, Floats b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static Mask lessEqual(Floats a, Floats b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static Mask greater(Floats a, Floats b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static Mask greaterEqual(Floats a, Floats b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static Mask both(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+    static Mask either(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+    static Mask loadMask(const uint32_t* in) { return _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in))); }
+    static Floats select(Mask mask, Floats a, Floats b) { return _mm256_blendv_ps(b, a, mask); }
+    static int bits(Mask mask) { return _mm256_movemask_ps(mask); }
+    //lanes whose byte has flag set
+    static Mask loadFlags(const uint8_t* in, uint8_t flag) {
+        __m128i zero = _mm_setzero_si128(), want = _mm_set1_epi32(flag);
+        __m128i words = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in)), zero);
+        __m128i low = _mm_unpacklo_epi16(words, zero), high = _mm_unpackhi_epi16(words, zero);
+        low = _mm_cmpeq_epi32(_mm_and_si128(low, want), want);
+        high = _mm_cmpeq_epi32(_mm_and_si128(high, want), want);
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_castsi128_ps(low)), _mm_castsi128_ps(high), 1);
+    }
+};
+#elif defined(FLAPPY_BATCH_SSE2)
+struct BatchLanes {
+    static const int WIDTH = 4;
+    typedef __m128 Floats;
+    typedef __m128 Mask;
+    static const char* name() { return "sse2"; }
+    static Floats load(const float* in) { return _mm_loadu_ps(in); }
+    static void store(float* out, Floats value) { _mm_storeu_ps(out, value); }
+    static Floats splat(float value) { return _mm_set1_ps(value); }
+    static Floats add(Floats a, Floats b) { return _mm_add_ps(a, b); }
+    static Floats sub(Floats a, Floats b) { return _mm_sub_ps(a, b); }
+    static Floats min(Floats a, Floats b) { return _mm_min_ps(a, b); }
+    static Floats max(Floats a, Floats b) { return _mm_max_ps(a, b); }
+    static Mask less(Floats a, Floats b) { return _mm_cmplt_ps(a, b); }
+    static Mask lessEqual(Floats a, Floats b) { return _mm_cmple_ps(a, b); }
+    static Mask greater(Floats a, Floats b) { return _mm_cmpgt_ps(a, b); }
+    static Mask greaterEqual(Floats a, Floats b) { return _mm_cmpge_ps(a, b); }
+    static Mask both(Mask a, Mask b) { return _mm_and_ps(a, b); }
+    static Mask either(Mask a, Mask b) { return _mm_or_ps(a, b); }
+    static Mask loadMask(const uint32_t* in) { return _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in))); }
+    static Floats select(Mask mask, Floats a, Floats b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+    static int bits(Mask mask) { return _mm_movemask_ps(mask); }
+    static Mask loadFlags(const uint8_t* in, uint8_t flag) {
+        int packed;
+        std::memcpy(&packed, in, sizeof(packed));
+        __m128i zero = _mm_setzero_si128(), want = _mm_set1_epi32(flag);
+        __m128i lanes = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+        return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(lanes, want), want));
+    }
+};
+#else
+struct BatchLanes {
+    static const int WIDTH = 1;
+    typedef float Floats;
+    typedef bool Mask;
+    static const char* name() { return "scalar"; }
+    static Floats load(const float* in) { return *in; }
+    static void store(float* out, Floats value) { *out = value; }
+    static Floats splat(float value) { return value; }
+    static Floats add(Floats a, Floats b) { return a + b; }
+    static Floats sub(Floats a, Floats b) { return a - b; }
+    static Floats min(Floats a, Floats b) { return a < b ? a : b; }
+    static Floats max(Floats a, Floats b) { return a > b ? a : b; }
+    static Mask less(Floats a, Floats b) { return a < b; }
+    static Mask lessEqual(Floats a, Floats b) { return a <= b; }
+    static Mask greater(Floats a, Floats b) { return a > b; }
+    static Mask greaterEqual(Floats a, Floats b) { return a >= b; }
+    static Mask both(Mask a, Mask b) { return a && b; }
+    static Mask either(Mask a, Mask b) { return a || b; }
+    static Mask loadMask(const uint32_t* in) { return *in != 0; }
+    static Floats select(Mask mask, Floats a, Floats b) { return mask ? a : b; }
+    static int bits(Mask mask) { return mask ? 1 : 0; }
+    static Mask loadFlags(const uint8_t* in, uint8_t flag) { return (*in & flag) != 0; }
+};
+#endif
+
+class FlappyBatch {
+private:
+    typedef BatchLanes L;
+    static const int WIDTH = BatchLanes::WIDTH;
+    static constexpr float INF = std::numeric_limits<float>::infinity();
+
+    size_t count;
+    size_t stride; // count rounded up to a whole number of lanes, the padding worlds never run
+    FlappySim rules; // per-tick physics for the tick rate, shared by every world
+    uint64_t clock; // ticks stepped by the batch
+
+    // Per world
+    std::vector<float> birdY;
+    std::vector<float> birdVelocity;
+    std::vector<float> birdRotation;
+    std::vector<uint32_t> running; // all ones while the game isn't over, a ready-made lane mask
+    std::vector<int> score;
+    std::vector<int> lives;
+    std::vector<float> pipeSpawnTimer; // whole numbers, exact as floats, so the timers count in lanes too
+    std::vector<uint32_t> firstPipe;
+    std::vector<uint32_t> nextScore;
+    std::vector<uint32_t> pipeEnd;
+    std::vector<uint32_t> liveSlots; // bit s set while slot s holds a pipe in [firstPipe, pipeEnd)
+    std::vector<uint64_t> startTick; // ticks() is the batch's clock since the world's reset...
+    std::vector<uint64_t> endTick; // ...up to its game over
+    std::vector<uint64_t> seeds;
+    std::vector<SimRandom> rngs;
+
+    // Per pipe slot per world, slot-major: slot s of world w is at s * stride + w, so one slot of
+    // neighbouring worlds loads as a vector. Indices map onto slots exactly as in FlappySim.
+    std::vector<float> pipeX;
+    std::vector<float> gapTop;
+    std::vector<float> gapBottom;
+    std::vector<uint32_t> pipeHit;
+
+    // Copies of the few pipes a tick looks at, moved along with their slots so they stay
+    // bit-identical, and reloaded only when an index moves on. INF when there's no such pipe.
+    // near is the first pipe not yet fully left of the bird, where FlappySim's collision walk
+    // starts doing anything; front is firstPipe and scored is nextScore.
+    std::vector<uint32_t> nearPipe;
+    std::vector<float> nearX;
+    std::vector<float> nearTop;
+    std::vector<float> nearBottom;
+    std::vector<uint32_t> nearHit;
+    std::vector<float> frontX;
+    std::vector<float> scoredX;
+
+    size_t slot(size_t world, uint32_t index) const { return (index & PIPE_POOL_MASK) * stride + world; }
+
+    void loadNear(size_t world) {
+        nearPipe[world] = std::max(nearPipe[world], firstPipe[world]);
+        if (nearPipe[world] == pipeEnd[world]) {
+            nearX[world] = INF;
+            nearHit[world] = 0;
+            return;
+        }
+        size_t at = slot(world, nearPipe[world]);
+        nearX[world] = pipeX[at];
+        nearTop[world] = gapTop[at];
+        nearBottom[world] = gapBottom[at];
+        nearHit[world] = pipeHit[at];
+    }
+
+    void loadFront(size_t world) {
+        frontX[world] = firstPipe[world] == nextScore[world] ? INF : pipeX[slot(world, firstPipe[world])];
+    }
+
+    void loadScored(size_t world) {
+        scoredX[world] = nextScore[world] == pipeEnd[world] ? INF : pipeX[slot(world, nextScore[world])];
+    }
+
+    void resetBird(size_t world) {
+        birdY[world] = BIRD_START_Y;
+        birdVelocity[world] = 0.f;
+        birdRotation[world] = 0.f;
+    }
+
+    uint8_t loseLife(size_t world) {
+        lives[world]--;
+        if (lives[world] <= 0) {
+            running[world] = 0;
+            endTick[world] = clock;
+            return EVENT_LIFE_LOST | EVENT_GAME_OVER;
+        }
+        resetBird(world);
+        return EVENT_LIFE_LOST;
+    }
+
+    void spawnPipe(size_t world) {
+        float height = static_cast<float>(rngs[world].range(PIPE_MIN_HEIGHT, PIPE_MAX_HEIGHT));
+        if (pipeEnd[world] - firstPipe[world] == PIPE_POOL_SIZE) {
+            if (nextScore[world] == firstPipe[world]) nextScore[world]++;
+            firstPipe[world]++;
+        }
+        liveSlots[world] |= 1u << (pipeEnd[world] & PIPE_POOL_MASK);
+        size_t at = slot(world, pipeEnd[world]++);
+        pipeX[at] = static_cast<float>(WINDOW_WIDTH);
+        gapTop[at] = height;
+        gapBottom[at] = height + PIPE_GAP;
+        pipeHit[at] = 0;
+        loadNear(world);
+        loadFront(world);
+        loadScored(world);
+    }
+
+    //FlappySim's collision walk from the pipe after near on, for the rare tick that reaches it
+    uint8_t collideBeyondNear(size_t world) {
+        const float birdLeft = BIRD_X - BIRD_SIZE / 2, birdRight = BIRD_X + BIRD_SIZE / 2;
+        uint8_t events = EVENT_NONE;
+        for (uint32_t i = nearPipe[world] + 1; i != pipeEnd[world] && pipeX[slot(world, i)] < birdRight; ++i) {
+            size_t at = slot(world, i);
+            if (pipeHit[at] || pipeX[at] + PIPE_WIDTH <= birdLeft) continue;
+            float top = birdY[world] - BIRD_SIZE / 2, bottom = birdY[world] + BIRD_SIZE / 2;
+            if (rectsOverlap(birdLeft, top, birdRight, bottom, pipeX[at], 0.f, pipeX[at] + PIPE_WIDTH, gapTop[at]) ||
+                rectsOverlap(birdLeft, top, birdRight, bottom, pipeX[at], gapBottom[at], pipeX[at] + PIPE_WIDTH, static_cast<float>(WINDOW_HEIGHT))) {
+                events |= loseLife(world);
+                if (!running[world]) return events;
+                pipeHit[at] = ~0u;
+            }
+        }
+        return events;
+    }
+
+    //calls visit(world) for every lane set in a mask
+    template <typename Visit>
+    static void forEachLane(int bits, size_t block, Visit visit) {
+        for (int lane = 0; bits; ++lane, bits >>= 1) {
+            if (bits & 1) visit(block + lane);
+        }
+    }
+
+    //calls visit(world) for lanes where test holds until it holds for none, for the indices that
+    //usually move at most once a tick
+    template <typename Test, typename Visit>
+    static void whileAnyLane(size_t block, Test test, Visit visit) {
+        for (int bits = L::bits(test()); bits; bits = L::bits(test())) {
+            forEachLane(bits, block, visit);
+        }
+    }
+
+    //one tick of WIDTH neighbouring worlds, mirrors FlappySim::step stage by stage. inputs and
+    //events hold the block's WIDTH entries, events already cleared
+    void stepBlock(size_t block, const uint8_t* inputs, uint8_t* events) {
+        // Bird physics
+        L::Mask live = L::loadMask(&running[block]);
+        L::Mask flap = L::both(live, L::loadFlags(inputs, INPUT_FLAP));
+        L::Floats velocity = L::add(L::select(flap, L::splat(rules.flapVelocity), L::load(&birdVelocity[block])), L::splat(rules.gravity));
+        L::Floats y = L::add(L::load(&birdY[block]), velocity);
+        L::Floats rotation = L::select(flap, L::splat(BIRD_FLAP_ROTATION), L::load(&birdRotation[block]));
+        L::Mask diving = L::both(L::less(rotation, L::splat(90.f)), L::greater(velocity, L::splat(0.f)));
+        rotation = L::select(diving, L::add(rotation, L::splat(rules.diveRotation)), rotation);
+        L::store(&birdVelocity[block], L::select(live, velocity, L::load(&birdVelocity[block])));
+        L::store(&birdY[block], L::select(live, y, L::load(&birdY[block])));
+        L::store(&birdRotation[block], L::select(live, rotation, L::load(&birdRotation[block])));
+
+        // Ground and ceiling
+        L::Mask grounded = L::both(live, L::either(L::lessEqual(y, L::splat(0.f)),
+            L::greaterEqual(L::add(y, L::splat(BIRD_SIZE / 2)), L::splat(static_cast<float>(WINDOW_HEIGHT)))));
+        forEachLane(L::bits(grounded), block, [&](size_t world) { events[world - block] |= loseLife(world); });
+
+        // Pipe spawning
+        live = L::loadMask(&running[block]);
+        L::Floats timer = L::add(L::load(&pipeSpawnTimer[block]), L::splat(1.f));
+        L::store(&pipeSpawnTimer[block], L::select(live, timer, L::load(&pipeSpawnTimer[block])));
+        forEachLane(L::bits(L::both(live, L::greaterEqual(timer, L::splat(static_cast<float>(rules.pipeSpawnTicks))))), block,
+            [&](size_t world) {
+                pipeSpawnTimer[world] = 0.f;
+                spawnPipe(world);
+            });
+
+        // Pipe movement, the slots live in any of the block's worlds (moving a free slot is harmless,
+        // it's overwritten on spawn) and the copies with them
+        L::Floats speed = L::splat(rules.pipeSpeed);
+        auto move = [&](float* x) { L::store(x, L::select(live, L::sub(L::load(x), speed), L::load(x))); };
+        uint32_t slots = 0;
+        for (int lane = 0; lane < WIDTH; ++lane) slots |= liveSlots[block + lane];
+        for (uint32_t pipe = 0; slots; ++pipe, slots >>= 1) {
+            if (slots & 1) move(&pipeX[pipe * stride + block]);
+        }
+        move(&nearX[block]);
+        move(&frontX[block]);
+        move(&scoredX[block]);
+
+        // Collision. Pipes fully left of the bird are skipped by FlappySim, so near moves past them
+        // first; then near is tested in every lane at once, and only a lane where near is under the
+        // bird can have another pipe there too
+        const float birdLeft = BIRD_X - BIRD_SIZE / 2, birdRight = BIRD_X + BIRD_SIZE / 2;
+        whileAnyLane(block, [&]() {
+            return L::both(live, L::lessEqual(L::add(L::load(&nearX[block]), L::splat(PIPE_WIDTH)), L::splat(birdLeft)));
+        }, [&](size_t world) {
+            nearPipe[world]++;
+            loadNear(world);
+        });
+
+        L::Floats x = L::load(&nearX[block]);
+        L::Mask near = L::both(live, L::less(x, L::splat(birdRight)));
+        int nearBits = L::bits(near);
+        if (nearBits) {
+            y = L::load(&birdY[block]); // losing a life on the ground put the bird back at the start
+            L::Floats top = L::sub(y, L::splat(BIRD_SIZE / 2)), bottom = L::add(y, L::splat(BIRD_SIZE / 2));
+            L::Mask across = L::less(L::max(L::splat(birdLeft), x), L::min(L::splat(birdRight), L::add(x, L::splat(PIPE_WIDTH))));
+            L::Mask upper = L::less(L::max(top, L::splat(0.f)), L::min(bottom, L::load(&nearTop[block])));
+            L::Mask lower = L::less(L::max(top, L::load(&nearBottom[block])), L::min(bottom, L::splat(static_cast<float>(WINDOW_HEIGHT))));
+            L::Mask hits = L::both(L::both(near, across), L::either(upper, lower));
+            forEachLane(L::bits(hits), block, [&](size_t world) {
+                if (nearHit[world]) return;
+                events[world - block] |= loseLife(world);
+                if (running[world]) {
+                    nearHit[world] = ~0u;
+                    pipeHit[slot(world, nearPipe[world])] = ~0u;
+                }
+            });
+            forEachLane(nearBits, block, [&](size_t world) {
+                if (running[world]) events[world - block] |= collideBeyondNear(world);
+            });
+            live = L::loadMask(&running[block]);
+        }
+
+        // Check if bird passed the pipe
+        whileAnyLane(block, [&]() {
+            return L::both(live, L::less(L::add(L::load(&scoredX[block]), L::splat(PIPE_WIDTH)), L::splat(BIRD_X)));
+        }, [&](size_t world) {
+            if (!pipeHit[slot(world, nextScore[world])]) {
+                score[world] += PIPE_POINTS;
+                events[world - block] |= EVENT_POINT;
+            }
+            nextScore[world]++;
+            loadScored(world);
+            loadFront(world);
+        });
+
+        // Remove off-screen pipes
+        whileAnyLane(block, [&]() {
+            return L::both(live, L::less(L::add(L::load(&frontX[block]), L::splat(PIPE_WIDTH)), L::splat(0.f)));
+        }, [&](size_t world) {
+            liveSlots[world] &= ~(1u << (firstPipe[world] & PIPE_POOL_MASK));
+            firstPipe[world]++;
+            loadFront(world);
+        });
+    }
+
+public:
+    explicit FlappyBatch(size_t worlds, int ticksPerSecond = SIM_TICKS_PER_SECOND)
+        : count(worlds), stride((worlds + WIDTH - 1) / WIDTH * WIDTH), rules(0, ticksPerSecond), clock(0),
+        birdY(stride), birdVelocity(stride), birdRotation(stride), running(stride, 0), score(stride), lives(stride),
+        pipeSpawnTimer(stride), firstPipe(stride), nextScore(stride), pipeEnd(stride), liveSlots(stride), startTick(stride), endTick(stride), seeds(stride),
+        rngs(stride), pipeX(stride * PIPE_POOL_SIZE), gapTop(stride * PIPE_POOL_SIZE),
+        gapBottom(stride * PIPE_POOL_SIZE), pipeHit(stride * PIPE_POOL_SIZE), nearPipe(stride), nearX(stride, INF),
+        nearTop(stride), nearBottom(stride), nearHit(stride), frontX(stride, INF), scoredX(stride, INF) {
+        for (size_t world = 0; world < count; ++world) reset(world, world);
+    }
+
+    //starts world over with a new seed, the others carry on
+    void reset(size_t world, uint64_t seed) {
+        seeds[world] = seed;
+        rngs[world].reseed(seed);
+        resetBird(world);
+        firstPipe[world] = 0;
+        nextScore[world] = 0;
+        pipeEnd[world] = 0;
+        liveSlots[world] = 0;
+        pipeSpawnTimer[world] = 0.f;
+        score[world] = 0;
+        lives[world] = START_LIVES;
+        running[world] = ~0u;
+        startTick[world] = clock;
+        endTick[world] = clock;
+        nearPipe[world] = 0;
+        loadNear(world);
+        loadFront(world);
+        loadScored(world);
+    }
+
+    //advances every world one tick, inputs[w] is world w's InputBits and events[w] gets its SimEvents.
+    //Finished worlds stay finished until reset.
+    void step(const uint8_t* inputs, uint8_t* events) {
+        clock++;
+        std::fill(events, events + count, EVENT_NONE);
+        size_t whole = count / WIDTH * WIDTH;
+        for (size_t block = 0; block < whole; block += WIDTH) {
+            stepBlock(block, inputs + block, events + block);
+        }
+        if (whole < count) {
+            // the last block runs past the end of the caller's arrays
+            uint8_t tailInputs[WIDTH] = {}, tailEvents[WIDTH] = {};
+            std::copy(inputs + whole, inputs + count, tailInputs);
+            stepBlock(whole, tailInputs, tailEvents);
+            std::copy(tailEvents, tailEvents + (count - whole), events + whole);
+        }
+    }
+
+    size_t size() const { return count; }
+    static const char* instructionSet() { return L::name(); }
+
+    float getBirdY(size_t world) const { return birdY[world]; }
+    float getBirdVelocity(size_t world) const { return birdVelocity[world]; }
+    float getBirdRotation(size_t world) const { return birdRotation[world]; }
+    int getScore(size_t world) const { return score[world]; }
+    int getLives(size_t world) const { return lives[world]; }
+    bool isGameOver(size_t world) const { return !running[world]; }
+    uint64_t getTicks(size_t world) const { return (running[world] ? clock : endTick[world]) - startTick[world]; }
+
+    //the first pipe the bird hasn't got past yet, false when there is none on screen
+    bool nextPipe(size_t world, float& x, float& top, float& bottom) const {
+        if (nextScore[world] == pipeEnd[world]) return false;
+        size_t at = slot(world, nextScore[world]);
+        x = pipeX[at];
+        top = gapTop[at];
+        bottom = gapBottom[at];
+        return true;
+    }
+
+    //one world's state as a FlappySim, to check against the single-world rules or to render it
+    FlappySim toSim(size_t world) const {
+        FlappySim sim = rules;
+        sim.birdY = birdY[world];
+        sim.birdVelocity = birdVelocity[world];
+        sim.birdRotation = birdRotation[world];
+        for (uint32_t pipe = 0; pipe < PIPE_POOL_SIZE; ++pipe) {
+            size_t at = pipe * stride + world;
+            sim.pipes[pipe] = { pipeX[at], gapTop[at], gapBottom[at], pipeHit[at] != 0 };
+        }
+        sim.firstPipe = firstPipe[world];
+        sim.nextScore = nextScore[world];
+        sim.pipeEnd = pipeEnd[world];
+        sim.pipeSpawnTimer = static_cast<int>(pipeSpawnTimer[world]);
+        sim.seed = seeds[world];
+        sim.rng = rngs[world];
+        sim.score = score[world];
+        sim.lives = lives[world];
+        sim.gameOver = !running[world];
+        sim.ticks = getTicks(world);
+        return sim;
+    }
+};
@@ -0,0 +1,213 @@
+#pragma once
+// Crash-safe multi-entry leaderboard. New scores are appended to a write-ahead log; the log is
+// folded into a snapshot written to a temp file and renamed over the old one, so a crash at any
+// point leaves either the old or the new state on disk, never a half-written one. Every write is
+// synced to the disk before the next step relies on it, so this holds through a power loss too,
+// not just a process crash. The top entries are kept sorted in memory, so recording is O(log N)
+// and reading never touches disk.
+#include <set>
+#include <iterator>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+struct ScoreRecord {
+    std::string name;
+    int score;
+    int64_t timestamp; // seconds since the epoch
+    uint64_t replayHash; // Replay::hash() of the round, 0 when unknown
+};
+
+// Highest score first, ties go to whoever got there first
+struct ScoreOrder {
+    bool operator()(const ScoreRecord& a, const ScoreRecord& b) const {
+        if (a.score != b.score) return a.score > b.score;
+        return a.timestamp < b.timestamp;
+    }
+};
+
+class Leaderboard {
+private:
+    std::string logPath;
+    std::string snapshotPath;
+    size_t capacity;
+    std::multiset<ScoreRecord, ScoreOrder> top;
+    int logRecords; // records in the log since the last compaction
+    int compactEvery;
+
+    static uint32_t checksum(const std::string& text) {
+        uint32_t hash = 2166136261u; // FNV-1a
+        for (unsigned char c : text) {
+            hash = (hash ^ c) * 16777619u;
+        }
+        return hash;
+    }
+
+    //one record per line: score, timestamp, replay hash, name, then a checksum of all of it
+    static std::string formatRecord(const ScoreRecord& record) {
+        std::ostringstream fields;
+        fields << record.score << '\t' << record.timestamp << '\t' << std::hex << record.replayHash << std::dec << '\t' << record.name;
+        std::ostringstream line;
+        line << fields.str() << '\t' << std::hex << checksum(fields.str()) << '\n';
+        return line.str();
+    }
+
+    //false for torn or corrupted lines, which are skipped
+    static bool parseRecord(const std::string& line, ScoreRecord& record) {
+        size_t split = line.rfind('\t');
+        if (split == std::string::npos) return false;
+        std::string fields = line.substr(0, split);
+
+        uint32_t stored = 0;
+        std::istringstream tail(line.substr(split + 1));
+        if (!(tail >> std::hex >> stored) || stored != checksum(fields)) return false;
+
+        std::istringstream in(fields);
+        if (!(in >> record.score >> record.timestamp >> std::hex >> record.replayHash >> std::dec)) return false;
+        in.get(); // the tab before the name
+        std::getline(in, record.name);
+        return true;
+    }
+
+    void insert(const ScoreRecord& record) {
+        // a crash between the snapshot rename and the log truncation leaves records in both
+        auto same = top.equal_range(record);
+        for (auto it = same.first; it != same.second; ++it) {
+            if (it->name == record.name && it->replayHash == record.replayHash) return;
+        }
+
+        top.insert(record);
+        if (top.size() > capacity) {
+            top.erase(std::prev(top.end()));
+        }
+    }
+
+    void readFile(const std::string& path, bool countAsLog) {
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            ScoreRecord record;
+            if (parseRecord(line, record)) {
+                insert(record);
+                if (countAsLog) logRecords++;
+            }
+        }
+    }
+
+    //writes text to the file and waits until it is on the disk, not just handed to the OS
+    static bool writeDurably(const std::string& path, const std::string& text, bool append) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), append ? FILE_APPEND_DATA : GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+            append ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        DWORD written = 0;
+        bool ok = WriteFile(file, text.data(), static_cast<DWORD>(text.size()), &written, nullptr) && written == text.size();
+        ok = FlushFileBuffers(file) && ok;
+        CloseHandle(file);
+        return ok;
+#else
+        int file = open(path.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+        if (file < 0) return false;
+        bool ok = true;
+        for (size_t done = 0; ok && done < text.size(); ) {
+            ssize_t written = write(file, text.data() + done, text.size() - done);
+            ok = written > 0;
+            if (ok) done += static_cast<size_t>(written);
+        }
+        ok = fsync(file) == 0 && ok;
+        return close(file) == 0 && ok;
+#endif
+    }
+
+    //renames over the target and makes the rename itself durable before returning
+    static bool replaceDurably(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        std::error_code error;
+        std::filesystem::rename(from, to, error);
+        if (error) return false;
+
+        // the rename lives in the directory, which has to be synced on its own
+        std::string dir = std::filesystem::path(to).parent_path().string();
+        int handle = open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+        if (handle < 0) return false;
+        bool ok = fsync(handle) == 0;
+        return close(handle) == 0 && ok;
+#endif
+    }
+
+    static std::string sanitize(std::string name) {
+        for (char& c : name) {
+            if (c == '\t' || c == '\n' || c == '\r') c = ' ';
+        }
+        return name.empty() ? "PLAYER" : name;
+    }
+
+public:
+    Leaderboard(const std::string& basePath, size_t topN = 10, int compactAfter = 64)
+        : logPath(basePath + ".log"), snapshotPath(basePath + ".dat"), capacity(topN), logRecords(0), compactEvery(compactAfter) {}
+
+    //reads the snapshot and replays the log over it, then folds the log in
+    void load() {
+        top.clear();
+        logRecords = 0;
+        readFile(snapshotPath, false);
+        readFile(logPath, true);
+        if (logRecords > 0) compact();
+    }
+
+    //imports the single number the old one-int high score files held, if there is no history yet
+    void importLegacy(const std::string& path) {
+        if (!top.empty()) return;
+        std::ifstream file(path);
+        int legacy = 0;
+        if (file >> legacy && legacy > 0) {
+            record({ "PLAYER", legacy, 0, 0 });
+        }
+    }
+
+    //appends to the log and updates the in-memory index, false if the score or a due compaction didn't reach the disk
+    bool record(ScoreRecord entry) {
+        entry.name = sanitize(entry.name);
+        insert(entry);
+
+        bool saved = writeDurably(logPath, formatRecord(entry), true);
+        if (++logRecords >= compactEvery) {
+            // on failure the log still holds everything, the next record tries again
+            saved = compact() && saved;
+        }
+        return saved;
+    }
+
+    //writes the top entries to a temp file, swaps it in with a rename, then empties the log
+    bool compact() {
+        std::string tempPath = snapshotPath + ".tmp";
+        std::string snapshot;
+        for (const auto& entry : top) {
+            snapshot += formatRecord(entry);
+        }
+        if (!writeDurably(tempPath, snapshot, false)) return false;
+        if (!replaceDurably(tempPath, snapshotPath)) return false;
+
+        // only once the snapshot holds everything on disk is the log dropped
+        std::ofstream(logPath, std::ios::trunc);
+        logRecords = 0;
+        return true;
+    }
+
+    int best() const { return top.empty() ? 0 : top.begin()->score; }
+    const std::multiset<ScoreRecord, ScoreOrder>& entries() const { return top; }
+};
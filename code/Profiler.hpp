@@ -0,0 +1,214 @@
+#pragma once
+// Frame-time instrumentation. Scoped timers push samples into a fixed ring buffer without
+// locking or allocating; the overlay summarizes the latest frames and the whole ring can be
+// written out as CSV or as a Chrome trace (chrome://tracing, Perfetto) when the game exits.
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <cstdint>
+
+// What a sample measured
+enum ProfileScope : uint8_t {
+    PROFILE_FRAME, // a whole pass of the main loop
+    PROFILE_EVENTS, // draining the window's event queue
+    PROFILE_INPUT,
+    PROFILE_UPDATE, // every simulation tick run in the frame
+    PROFILE_DRAW,
+    PROFILE_DISPLAY, // window.display(), including any frame-limit wait
+    PROFILE_SCOPE_COUNT
+};
+
+// Which screen was up when the sample was taken
+enum ProfileState : uint8_t {
+    STATE_MENU,
+    STATE_SNAKE,
+    STATE_FLAPPY,
+    STATE_INSTRUCTIONS,
+    STATE_HIGH_SCORES,
+    STATE_LOADING,
+    STATE_COUNT
+};
+
+inline const char* profileScopeName(ProfileScope scope) {
+    static const char* names[PROFILE_SCOPE_COUNT] = { "frame", "events", "input", "update", "draw", "display" };
+    return scope < PROFILE_SCOPE_COUNT ? names[scope] : "unknown";
+}
+
+inline const char* profileStateName(ProfileState state) {
+    static const char* names[STATE_COUNT] = { "menu", "snake", "flappy", "instructions", "high_scores", "loading" };
+    return state < STATE_COUNT ? names[state] : "unknown";
+}
+
+struct ProfileSample {
+    uint64_t startNs; // since the profiler started
+    uint32_t durationNs;
+    ProfileScope scope;
+    ProfileState state;
+};
+
+// p50/p99/max of one scope over recent samples, in milliseconds
+struct ProfileSummary {
+    int samples;
+    double p50;
+    double p99;
+    double max;
+};
+
+const uint32_t PROFILE_RING_SIZE = 1 << 17; // power of two, a few minutes of frames
+const int PROFILE_SUMMARY_SAMPLES = 240;
+
+class Profiler {
+private:
+    // Each slot carries a sequence number so a reader can tell a finished sample from one that
+    // is being overwritten: odd while writing, 2 * (index + 1) once published.
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        ProfileSample sample;
+    };
+
+    std::array<Slot, PROFILE_RING_SIZE> ring;
+    std::atomic<uint64_t> head; // total samples ever pushed
+    std::atomic<uint8_t> state;
+    std::chrono::steady_clock::time_point epoch;
+
+    Profiler() : head(0), state(STATE_MENU), epoch(std::chrono::steady_clock::now()) {
+        for (auto& slot : ring) slot.sequence.store(0, std::memory_order_relaxed);
+    }
+
+    //copies sample number index out of the ring, false if it was overwritten or not finished
+    bool read(uint64_t index, ProfileSample& out) const {
+        const Slot& slot = ring[index & (PROFILE_RING_SIZE - 1)];
+        uint64_t published = 2 * (index + 1);
+        if (slot.sequence.load(std::memory_order_acquire) != published) return false;
+        out = slot.sample;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == published;
+    }
+
+    uint64_t oldest() const {
+        uint64_t newest = head.load(std::memory_order_acquire);
+        return newest > PROFILE_RING_SIZE ? newest - PROFILE_RING_SIZE : 0;
+    }
+
+public:
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    static Profiler& instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    uint64_t now() const {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count());
+    }
+
+    void setState(ProfileState current) { state.store(current, std::memory_order_relaxed); }
+    ProfileState getState() const { return static_cast<ProfileState>(state.load(std::memory_order_relaxed)); }
+
+    //safe to call from any thread, never blocks
+    void push(ProfileScope scope, ProfileState sampleState, uint64_t startNs, uint64_t endNs) {
+        uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = ring[index & (PROFILE_RING_SIZE - 1)];
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        uint64_t duration = endNs - startNs;
+        slot.sample = { startNs, static_cast<uint32_t>(std::min<uint64_t>(duration, UINT32_MAX)), scope, sampleState };
+        slot.sequence.store(2 * (index + 1), std::memory_order_release);
+    }
+
+    //percentiles of the latest samples of one scope, without allocating
+    ProfileSummary summarize(ProfileScope scope, int maxSamples = PROFILE_SUMMARY_SAMPLES) const {
+        std::array<uint32_t, PROFILE_SUMMARY_SAMPLES> durations;
+        int count = 0;
+        int limit = std::min(maxSamples, PROFILE_SUMMARY_SAMPLES);
+        uint64_t first = oldest();
+        for (uint64_t index = head.load(std::memory_order_acquire); index > first && count < limit; --index) {
+            ProfileSample sample;
+            if (read(index - 1, sample) && sample.scope == scope) {
+                durations[count++] = sample.durationNs;
+            }
+        }
+
+        ProfileSummary summary = { count, 0.0, 0.0, 0.0 };
+        if (count == 0) return summary;
+        auto at = [&](int rank) {
+            std::nth_element(durations.begin(), durations.begin() + rank, durations.begin() + count);
+            return durations[rank] / 1e6;
+        };
+        summary.p50 = at(count / 2);
+        summary.p99 = at((count * 99) / 100);
+        summary.max = at(count - 1);
+        return summary;
+    }
+
+    //state,scope,start_us,duration_us per line
+    bool writeCsv(const std::string& path) const {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file.is_open()) return false;
+        file << std::fixed << std::setprecision(3) << "state,scope,start_us,duration_us\n";
+        forEachSample([&file](const ProfileSample& sample) {
+            file << profileStateName(sample.state) << ',' << profileScopeName(sample.scope) << ','
+                << sample.startNs / 1000.0 << ',' << sample.durationNs / 1000.0 << '\n';
+        });
+        return static_cast<bool>(file);
+    }
+
+    //Chrome trace-event format, complete ("X") events with the screen as the category
+    bool writeChromeTrace(const std::string& path) const {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file.is_open()) return false;
+        file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+        bool first = true;
+        forEachSample([&file, &first](const ProfileSample& sample) {
+            file << (first ? "" : ",\n") << "{\"name\":\"" << profileScopeName(sample.scope)
+                << "\",\"cat\":\"" << profileStateName(sample.state)
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << sample.startNs / 1000.0
+                << ",\"dur\":" << sample.durationNs / 1000.0 << "}";
+            first = false;
+        });
+        file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        return static_cast<bool>(file);
+    }
+
+    //.json gets a Chrome trace, anything else CSV
+    bool writeFile(const std::string& path) const {
+        bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+        return json ? writeChromeTrace(path) : writeCsv(path);
+    }
+
+    //oldest first, skipping anything overwritten while reading
+    template <typename Visit>
+    void forEachSample(Visit visit) const {
+        uint64_t last = head.load(std::memory_order_acquire);
+        for (uint64_t index = oldest(); index < last; ++index) {
+            ProfileSample sample;
+            if (read(index, sample)) visit(sample);
+        }
+    }
+};
+
+// Times the enclosing block
+class ScopedTimer {
+private:
+    ProfileScope scope;
+    ProfileState state;
+    uint64_t start;
+
+public:
+    explicit ScopedTimer(ProfileScope timedScope)
+        : scope(timedScope), state(Profiler::instance().getState()), start(Profiler::instance().now()) {}
+
+    ~ScopedTimer() {
+        Profiler& profiler = Profiler::instance();
+        profiler.push(scope, state, start, profiler.now());
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
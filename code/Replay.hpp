@@ -0,0 +1,204 @@
+#pragma once
+// Recorded rounds: the seed plus one input bitmask per tick is enough to re-run a round
+// exactly, so replays are tiny and can be verified headlessly far faster than real time.
+#include "Simulation.hpp"
+#include <string>
+#include <fstream>
+
+enum GameKind : uint8_t {
+    GAME_SNAKE = 1,
+    GAME_FLAPPY = 2
+};
+
+inline const char* gameName(GameKind game) { return game == GAME_SNAKE ? "snake" : "flappy"; }
+
+// Replay file layout, little-endian:
+//   "ARPL" u8 version, u8 game, u16 tickRate, u64 seed, u32 tickCount, i32 finalScore,
+//   u32 runBytes, then the inputs as (u8 bits, varint run length) pairs
+const uint8_t REPLAY_VERSION = 1;
+const int REPLAY_HEADER_SIZE = 28;
+const size_t REPLAY_RESERVE_BYTES = 4096; // enough runs for a long round, so recording doesn't allocate mid-game
+
+struct Replay {
+    GameKind game;
+    int tickRate;
+    uint64_t seed;
+    uint32_t tickCount;
+    int32_t finalScore;
+    std::vector<uint8_t> runs; // run-length encoded input bitmasks
+    uint8_t pendingBits; // run still being recorded
+    uint32_t pendingLength;
+
+    Replay() : game(GAME_SNAKE), tickRate(SIM_TICKS_PER_SECOND), seed(0), tickCount(0), finalScore(0),
+        pendingBits(0), pendingLength(0) {}
+
+    void start(GameKind kind, int ticksPerSecond, uint64_t gameSeed) {
+        game = kind;
+        tickRate = ticksPerSecond;
+        seed = gameSeed;
+        tickCount = 0;
+        finalScore = 0;
+        runs.clear();
+        runs.reserve(REPLAY_RESERVE_BYTES);
+        pendingBits = 0;
+        pendingLength = 0;
+    }
+
+    //one call per simulated tick
+    void record(uint8_t bits) {
+        if (pendingLength > 0 && bits != pendingBits) {
+            flushRun();
+        }
+        pendingBits = bits;
+        pendingLength++;
+        tickCount++;
+    }
+
+    void finish(int score) {
+        if (pendingLength > 0) flushRun();
+        finalScore = score;
+    }
+
+    //identifies the round: FNV-1a over everything that determines its outcome
+    uint64_t hash() const {
+        uint64_t h = 14695981039346656037ULL;
+        auto mix = [&h](uint64_t value, int bytes) {
+            for (int i = 0; i < bytes; ++i) {
+                h = (h ^ static_cast<uint8_t>(value >> (8 * i))) * 1099511628211ULL;
+            }
+        };
+        mix(game, 1);
+        mix(static_cast<uint64_t>(tickRate), 2);
+        mix(seed, 8);
+        mix(tickCount, 4);
+        mix(static_cast<uint32_t>(finalScore), 4);
+        for (uint8_t byte : runs) mix(byte, 1);
+        return h;
+    }
+
+    bool save(const std::string& path) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+
+        std::vector<uint8_t> header;
+        header.insert(header.end(), { 'A', 'R', 'P', 'L', REPLAY_VERSION, static_cast<uint8_t>(game) });
+        putLE(header, static_cast<uint64_t>(tickRate), 2);
+        putLE(header, seed, 8);
+        putLE(header, tickCount, 4);
+        putLE(header, static_cast<uint32_t>(finalScore), 4);
+        putLE(header, static_cast<uint64_t>(runs.size()), 4);
+
+        file.write(reinterpret_cast<const char*>(header.data()), header.size());
+        file.write(reinterpret_cast<const char*>(runs.data()), runs.size());
+        return static_cast<bool>(file);
+    }
+
+    bool load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return false;
+
+        uint8_t header[REPLAY_HEADER_SIZE];
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) return false;
+        if (header[0] != 'A' || header[1] != 'R' || header[2] != 'P' || header[3] != 'L' || header[4] != REPLAY_VERSION) return false;
+        if (header[5] != GAME_SNAKE && header[5] != GAME_FLAPPY) return false;
+
+        game = static_cast<GameKind>(header[5]);
+        tickRate = static_cast<int>(getLE(header + 6, 2));
+        seed = getLE(header + 8, 8);
+        tickCount = static_cast<uint32_t>(getLE(header + 16, 4));
+        finalScore = static_cast<int32_t>(getLE(header + 20, 4));
+        uint32_t runBytes = static_cast<uint32_t>(getLE(header + 24, 4));
+        if (tickRate <= 0) return false;
+
+        // runBytes comes from the file, so don't allocate for more than the file actually holds
+        std::streampos runsStart = file.tellg();
+        file.seekg(0, std::ios::end);
+        std::streamoff available = file.tellg() - runsStart;
+        file.seekg(runsStart);
+        if (!file || available < static_cast<std::streamoff>(runBytes)) return false;
+
+        runs.resize(runBytes);
+        pendingLength = 0;
+        return runBytes == 0 || static_cast<bool>(file.read(reinterpret_cast<char*>(runs.data()), runBytes));
+    }
+
+private:
+    void flushRun() {
+        runs.push_back(pendingBits);
+        uint32_t length = pendingLength;
+        while (length >= 0x80) {
+            runs.push_back(static_cast<uint8_t>(length | 0x80));
+            length >>= 7;
+        }
+        runs.push_back(static_cast<uint8_t>(length));
+        pendingLength = 0;
+    }
+
+    static void putLE(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    static uint64_t getLE(const uint8_t* in, int bytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+        return value;
+    }
+};
+
+// Walks a replay's runs handing back one input bitmask per tick
+class ReplayCursor {
+private:
+    const Replay* replay;
+    size_t position;
+    uint8_t bits;
+    uint32_t remaining;
+
+public:
+    explicit ReplayCursor(const Replay& source) : replay(&source), position(0), bits(INPUT_NONE), remaining(0) {}
+
+    //INPUT_NONE once the recording has run out
+    uint8_t next() {
+        while (remaining == 0) {
+            if (position >= replay->runs.size()) return INPUT_NONE;
+            bits = replay->runs[position++];
+            uint32_t length = 0;
+            // a u32 run length is at most 5 varint bytes, stop there on a malformed file
+            for (int shift = 0; shift < 35 && position < replay->runs.size(); shift += 7) {
+                uint8_t byte = replay->runs[position++];
+                length |= static_cast<uint32_t>(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) break;
+            }
+            remaining = length;
+        }
+        remaining--;
+        return bits;
+    }
+};
+
+struct ReplayResult {
+    int score;
+    uint32_t ticks;
+    bool gameOver;
+};
+
+template <typename Sim>
+ReplayResult runReplay(const Replay& replay) {
+    Sim sim(replay.seed, replay.tickRate);
+    ReplayCursor cursor(replay);
+    for (uint32_t i = 0; i < replay.tickCount && !sim.gameOver; ++i) {
+        sim.step(cursor.next());
+    }
+    return { sim.score, static_cast<uint32_t>(sim.ticks), sim.gameOver };
+}
+
+//re-simulates the round without rendering
+inline ReplayResult simulateReplay(const Replay& replay) {
+    return replay.game == GAME_SNAKE ? runReplay<SnakeSim>(replay) : runReplay<FlappySim>(replay);
+}
+
+//a replay checks out if re-running it ends the round on the same tick with the same score
+inline bool verifyReplay(const Replay& replay, ReplayResult* result = nullptr) {
+    ReplayResult outcome = simulateReplay(replay);
+    if (result) *result = outcome;
+    return outcome.gameOver && outcome.score == replay.finalScore && outcome.ticks == replay.tickCount;
+}
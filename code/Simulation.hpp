@@ -0,0 +1,503 @@
+#pragma once
+// Render-free game rules for Eat The Emoji (snake) and Basim Bird (flappy).
+// Nothing in here touches SFML, so the games can be stepped without a window
+// (soak tests, bots, replays) as fast as the CPU allows.
+// The rules are those of the sprite-based originals with four deliberate changes, listed in the
+// README: 5 points per pipe pair, a fixed square bird hitbox, a pipe hit clears the whole pair, and
+// food is only eaten by moving onto its cell.
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cmath>
+
+//Declaring  Constants
+const int WINDOW_WIDTH = 1000; //defining window width
+const int WINDOW_HEIGHT = 800; //defining window height
+
+// Both games advance in fixed ticks, 60 per second unless the loop is configured otherwise.
+// Tuning constants below are given per tick at this default rate.
+const int SIM_TICKS_PER_SECOND = 60;
+const int START_LIVES = 3;
+
+// Input bitmask handed to step() once per tick
+enum InputBits : uint8_t {
+    INPUT_NONE = 0,
+    INPUT_UP = 1 << 0,
+    INPUT_DOWN = 1 << 1,
+    INPUT_LEFT = 1 << 2,
+    INPUT_RIGHT = 1 << 3,
+    INPUT_FLAP = 1 << 4
+};
+
+// Things that happened during a tick, the renderer turns these into sounds and high score saves
+enum SimEvents : uint8_t {
+    EVENT_NONE = 0,
+    EVENT_POINT = 1 << 0,
+    EVENT_LIFE_LOST = 1 << 1,
+    EVENT_GAME_OVER = 1 << 2
+};
+
+// Fast seedable generator (PCG32) used for food and pipe placement. Unlike std::mt19937 with the
+// standard distributions its output is fully specified, so a seed gives the same game on every
+// platform and compiler, which replays and benchmarks rely on.
+class SimRandom {
+private:
+    uint64_t state;
+    uint64_t increment;
+
+public:
+    explicit SimRandom(uint64_t seed = 0) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        state = 0;
+        increment = (seed << 1) | 1u;
+        next();
+        state += seed ^ 0x853c49e6748fea9bULL;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+        uint32_t xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = static_cast<uint32_t>(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+    }
+
+    uint64_t next64() { return (static_cast<uint64_t>(next()) << 32) | next(); }
+
+    //unbiased value in [0, bound), Lemire's multiply-and-reject
+    uint32_t below(uint32_t bound) {
+        uint64_t m = static_cast<uint64_t>(next()) * bound;
+        uint32_t low = static_cast<uint32_t>(m);
+        if (low < bound) {
+            uint32_t threshold = (0u - bound) % bound;
+            while (low < threshold) {
+                m = static_cast<uint64_t>(next()) * bound;
+                low = static_cast<uint32_t>(m);
+            }
+        }
+        return static_cast<uint32_t>(m >> 32);
+    }
+
+    //value in [low, high]
+    int range(int low, int high) { return low + static_cast<int>(below(static_cast<uint32_t>(high - low + 1))); }
+};
+
+// Snake board
+const int SNAKE_GRID_SIZE = 32;
+const int SNAKE_COLS = WINDOW_WIDTH / SNAKE_GRID_SIZE; // 31
+const int SNAKE_ROWS = WINDOW_HEIGHT / SNAKE_GRID_SIZE; // 25
+const int SNAKE_START_X = (WINDOW_WIDTH / 2) / SNAKE_GRID_SIZE;
+const int SNAKE_START_Y = (WINDOW_HEIGHT / 2) / SNAKE_GRID_SIZE;
+const int SNAKE_START_LENGTH = 3;
+const int SNAKE_MAX_LENGTH = 1024; // power of two above the 775 board cells, the body ring buffer size
+const float SNAKE_MOVE_SECONDS = 0.15f; // one step every 0.15 seconds whatever the tick rate
+const int SNAKE_FOOD_POINTS = 10;
+
+// Headings are ordered so that heading * 90 is the sprite rotation
+enum SnakeDirection : uint8_t {
+    DIR_RIGHT = 0,
+    DIR_DOWN = 1,
+    DIR_LEFT = 2,
+    DIR_UP = 3
+};
+
+inline int directionX(SnakeDirection dir) { return dir == DIR_RIGHT ? 1 : (dir == DIR_LEFT ? -1 : 0); }
+inline int directionY(SnakeDirection dir) { return dir == DIR_DOWN ? 1 : (dir == DIR_UP ? -1 : 0); }
+
+//the input that turns the snake towards dir
+inline uint8_t directionInput(SnakeDirection dir) {
+    static const uint8_t bits[] = { INPUT_RIGHT, INPUT_DOWN, INPUT_LEFT, INPUT_UP };
+    return bits[dir];
+}
+
+struct SnakeCell {
+    int8_t x;
+    int8_t y;
+    SnakeDirection direction; // heading the segment was moving in, used for its rotation
+};
+
+// Occupancy grid for the snake board, kept in step with the body as the head advances and the
+// tail retracts. Each cell counts the segments on it (a freshly grown segment sits on top of the
+// tail for a step) and free cells are kept in a dense list, so both "is this cell taken?" and
+// "pick a random empty cell" are O(1).
+struct SnakeBoard {
+    static constexpr int CELLS = SNAKE_COLS * SNAKE_ROWS;
+
+    uint16_t segments[CELLS];
+    int16_t freeCells[CELLS]; // the first freeCount entries are the empty cells
+    int16_t freeSlot[CELLS]; // where a cell sits in freeCells, -1 while occupied
+    int freeCount;
+
+    static int index(int x, int y) { return y * SNAKE_COLS + x; }
+    static bool inBounds(int x, int y) { return x >= 0 && x < SNAKE_COLS && y >= 0 && y < SNAKE_ROWS; }
+
+    void clear() {
+        for (int i = 0; i < CELLS; ++i) {
+            segments[i] = 0;
+            freeCells[i] = static_cast<int16_t>(i);
+            freeSlot[i] = static_cast<int16_t>(i);
+        }
+        freeCount = CELLS;
+    }
+
+    bool isOccupied(int x, int y) const { return segments[index(x, y)] != 0; }
+
+    void add(int x, int y) {
+        int cell = index(x, y);
+        if (segments[cell]++ != 0) return;
+
+        // swap the cell with the last free one and shrink the free list
+        int slot = freeSlot[cell];
+        int last = freeCells[--freeCount];
+        freeCells[slot] = static_cast<int16_t>(last);
+        freeSlot[last] = static_cast<int16_t>(slot);
+        freeCells[freeCount] = static_cast<int16_t>(cell);
+        freeSlot[cell] = -1;
+    }
+
+    void remove(int x, int y) {
+        int cell = index(x, y);
+        if (--segments[cell] != 0) return;
+
+        freeCells[freeCount] = static_cast<int16_t>(cell);
+        freeSlot[cell] = static_cast<int16_t>(freeCount);
+        freeCount++;
+    }
+};
+
+// Snake rules on a SNAKE_COLS x SNAKE_ROWS grid
+struct SnakeSim {
+    // The body is a ring buffer: a step writes one new head cell in front of the old one and the
+    // tail falls off the end, so a move costs the same however long the snake is
+    SnakeCell cells[SNAKE_MAX_LENGTH];
+    int headIndex;
+    int length;
+    uint32_t bodyVersion; // bumped whenever the body changes, renderers cache against it
+    SnakeBoard board;
+    uint64_t seed; // the seed this game was started with
+    SimRandom rng;
+    SnakeDirection direction;
+    int foodX; // -1 when the snake covers the whole board
+    int foodY;
+    int score;
+    int lives;
+    bool gameOver;
+    int moveTimer; // ticks since the last step
+    int moveTicks; // ticks between steps at the current tick rate
+    uint64_t ticks;
+
+    SnakeSim(uint64_t gameSeed = 0, int ticksPerSecond = SIM_TICKS_PER_SECOND) : bodyVersion(0) {
+        setTickRate(ticksPerSecond);
+        reset(gameSeed);
+    }
+
+    void setTickRate(int ticksPerSecond) {
+        moveTicks = static_cast<int>(std::lround(SNAKE_MOVE_SECONDS * ticksPerSecond));
+        if (moveTicks < 1) moveTicks = 1;
+    }
+
+    //starts a new game, the same seed always produces the same food positions
+    void reset(uint64_t gameSeed) {
+        seed = gameSeed;
+        rng.reseed(gameSeed);
+        board.clear();
+        headIndex = 0;
+        length = SNAKE_START_LENGTH;
+        bodyVersion++;
+        for (int i = 0; i < SNAKE_START_LENGTH; ++i) {
+            cells[i] = { static_cast<int8_t>(SNAKE_START_X), static_cast<int8_t>(SNAKE_START_Y + i), DIR_RIGHT };
+            board.add(SNAKE_START_X, SNAKE_START_Y + i);
+        }
+        direction = DIR_UP;
+        score = 0;
+        lives = START_LIVES;
+        gameOver = false;
+        moveTimer = 0;
+        ticks = 0;
+        spawnFood();
+    }
+
+    //i = 0 is the head, length - 1 the tail
+    const SnakeCell& segment(int i) const { return cells[(headIndex + i) & (SNAKE_MAX_LENGTH - 1)]; }
+    SnakeCell& head() { return cells[headIndex]; }
+    SnakeCell& tail() { return cells[(headIndex + length - 1) & (SNAKE_MAX_LENGTH - 1)]; }
+
+    //places food on a uniformly chosen empty cell
+    void spawnFood() {
+        if (board.freeCount == 0) {
+            foodX = foodY = -1;
+            return;
+        }
+        int cell = board.freeCells[rng.below(static_cast<uint32_t>(board.freeCount))];
+        foodX = cell % SNAKE_COLS;
+        foodY = cell / SNAKE_COLS;
+    }
+
+    //advances the game by one tick, returns the SimEvents raised
+    uint8_t step(uint8_t input) {
+        if (gameOver) return EVENT_NONE;
+        ticks++;
+
+        // Steering, the snake can never turn straight back onto itself
+        if ((input & INPUT_UP) && directionY(direction) == 0) direction = DIR_UP;
+        else if ((input & INPUT_DOWN) && directionY(direction) == 0) direction = DIR_DOWN;
+        else if ((input & INPUT_LEFT) && directionX(direction) == 0) direction = DIR_LEFT;
+        else if ((input & INPUT_RIGHT) && directionX(direction) == 0) direction = DIR_RIGHT;
+
+        if (++moveTimer < moveTicks) return EVENT_NONE;
+        moveTimer = 0;
+        return move();
+    }
+
+private:
+    uint8_t loseLife() {
+        lives--;
+        if (lives <= 0) {
+            gameOver = true;
+            return EVENT_LIFE_LOST | EVENT_GAME_OVER;
+        }
+        // Reset head position but keep score
+        head().x = SNAKE_START_X;
+        head().y = SNAKE_START_Y;
+        direction = DIR_UP;
+        return EVENT_LIFE_LOST;
+    }
+
+    uint8_t move() {
+        uint8_t events = EVENT_NONE;
+        bodyVersion++;
+
+        // Move snake, the tail leaves its cell before the head claims a new one.
+        // The new head takes the slot in front of the old head, which at full capacity is the old tail's.
+        board.remove(tail().x, tail().y);
+        SnakeCell next = head();
+        next.x = static_cast<int8_t>(next.x + directionX(direction));
+        next.y = static_cast<int8_t>(next.y + directionY(direction));
+        next.direction = direction;
+        headIndex = (headIndex - 1) & (SNAKE_MAX_LENGTH - 1);
+        head() = next;
+
+        // Check collisions with walls
+        if (!SnakeBoard::inBounds(head().x, head().y)) {
+            events |= loseLife();
+            if (gameOver) return events;
+        }
+
+        // Check collision with self
+        if (board.isOccupied(head().x, head().y)) {
+            events |= loseLife();
+            if (gameOver) return events;
+        }
+        board.add(head().x, head().y);
+
+        // Check collision with food
+        if (head().x == foodX && head().y == foodY) {
+            score += SNAKE_FOOD_POINTS;
+            if (length < SNAKE_MAX_LENGTH) {
+                // new segment sits on the tail and appears once the tail moves on
+                SnakeCell newTail = tail();
+                length++;
+                tail() = newTail;
+                board.add(newTail.x, newTail.y);
+            }
+            spawnFood();
+            events |= EVENT_POINT;
+        }
+        return events;
+    }
+};
+
+// Bird game
+const float BIRD_X = static_cast<float>(WINDOW_WIDTH) / 4.0f;
+const float BIRD_START_Y = static_cast<float>(WINDOW_HEIGHT) / 2.0f;
+const float BIRD_SIZE = 40.4f; // basimbird.png is 404px drawn at 0.1 scale, the hitbox doesn't turn with the sprite
+const float BIRD_GRAVITY = 0.5f;
+const float BIRD_FLAP_VELOCITY = -10.f;
+const float BIRD_FLAP_ROTATION = -30.f;
+const float BIRD_DIVE_ROTATION = 2.0f;
+const float PIPE_WIDTH = 80.f;
+const float PIPE_GAP = 200.f;
+const float PIPE_SPEED = 3.f;
+const int PIPE_SPAWN_TICKS = 200;
+const int PIPE_MIN_HEIGHT = 100;
+const int PIPE_MAX_HEIGHT = WINDOW_HEIGHT - 300;
+const int PIPE_POINTS = 5;
+const uint32_t PIPE_POOL_SIZE = 16; // power of two, far more pipes than ever fit on screen
+const uint32_t PIPE_POOL_MASK = PIPE_POOL_SIZE - 1;
+
+struct PipePair {
+    float x;
+    float gapTop; // bottom of the upper pipe
+    float gapBottom; // top of the lower pipe
+    bool hit; // the bird crashed into it, it no longer collides, scores or draws
+};
+
+//same test as sf::FloatRect::intersects, edges that only touch don't count
+inline bool rectsOverlap(float l1, float t1, float r1, float b1, float l2, float t2, float r2, float b2) {
+    return (l1 > l2 ? l1 : l2) < (r1 < r2 ? r1 : r2) && (t1 > t2 ? t1 : t2) < (b1 < b2 ? b1 : b2);
+}
+
+// Flappy rules, one tick is one physics frame
+struct FlappySim {
+    float birdY;
+    float birdVelocity;
+    float birdRotation; // degrees, negative is nose up
+    // Pipes all scroll at the same speed and spawn at the right edge, so they stay sorted by x.
+    // They live in a fixed ring of slots: pipes [firstPipe, pipeEnd) are on screen, everything
+    // before nextScore has been passed, so spawning, cleanup and scoring just bump an index and
+    // a game never allocates. Indices only grow, pipe(i) maps them onto slots.
+    std::array<PipePair, PIPE_POOL_SIZE> pipes;
+    uint32_t firstPipe;
+    uint32_t nextScore;
+    uint32_t pipeEnd;
+    int pipeSpawnTimer;
+    uint64_t seed; // the seed this game was started with
+    SimRandom rng;
+    int score;
+    int lives;
+    bool gameOver;
+    uint64_t ticks;
+
+    // Per-tick values derived from the tuning constants for the current tick rate
+    float gravity;
+    float flapVelocity;
+    float diveRotation;
+    float pipeSpeed;
+    int pipeSpawnTicks;
+
+    FlappySim(uint64_t gameSeed = 0, int ticksPerSecond = SIM_TICKS_PER_SECOND) {
+        setTickRate(ticksPerSecond);
+        reset(gameSeed);
+    }
+
+    //rescales the per-tick physics so the game plays at the same speed at any tick rate
+    void setTickRate(int ticksPerSecond) {
+        float scale = static_cast<float>(SIM_TICKS_PER_SECOND) / ticksPerSecond;
+        gravity = BIRD_GRAVITY * scale * scale;
+        flapVelocity = BIRD_FLAP_VELOCITY * scale;
+        diveRotation = BIRD_DIVE_ROTATION * scale;
+        pipeSpeed = PIPE_SPEED * scale;
+        pipeSpawnTicks = static_cast<int>(std::lround(PIPE_SPAWN_TICKS / scale));
+        if (pipeSpawnTicks < 1) pipeSpawnTicks = 1;
+    }
+
+    //starts a new game, the same seed always produces the same pipes
+    void reset(uint64_t gameSeed) {
+        seed = gameSeed;
+        rng.reseed(gameSeed);
+        resetBird();
+        firstPipe = 0;
+        nextScore = 0;
+        pipeEnd = 0;
+        pipeSpawnTimer = 0;
+        score = 0;
+        lives = START_LIVES;
+        gameOver = false;
+        ticks = 0;
+    }
+
+    void spawnPipe() {
+        float height = static_cast<float>(rng.range(PIPE_MIN_HEIGHT, PIPE_MAX_HEIGHT));
+
+        // the ring is full, recycle the oldest slot
+        if (pipeEnd - firstPipe == PIPE_POOL_SIZE) {
+            if (nextScore == firstPipe) nextScore++;
+            firstPipe++;
+        }
+        pipe(pipeEnd++) = { static_cast<float>(WINDOW_WIDTH), height, height + PIPE_GAP, false };
+    }
+
+    PipePair& pipe(uint32_t index) { return pipes[index & PIPE_POOL_MASK]; }
+    const PipePair& pipe(uint32_t index) const { return pipes[index & PIPE_POOL_MASK]; }
+
+    //advances the game by one tick, returns the SimEvents raised
+    uint8_t step(uint8_t input) {
+        if (gameOver) return EVENT_NONE;
+        ticks++;
+        uint8_t events = EVENT_NONE;
+
+        if (input & INPUT_FLAP) {
+            birdVelocity = flapVelocity;
+            birdRotation = BIRD_FLAP_ROTATION; // Tilt up when jumping
+        }
+
+        // Bird physics
+        birdVelocity += gravity;
+        birdY += birdVelocity;
+
+        // Gradually rotate bird downward
+        if (birdRotation < 90 && birdVelocity > 0) {
+            birdRotation += diveRotation;
+        }
+
+        // Check collisions with ground or ceiling
+        if (birdY <= 0 || birdY + BIRD_SIZE / 2 >= WINDOW_HEIGHT) {
+            events |= loseLife();
+            if (gameOver) return events;
+        }
+
+        // Pipe spawning
+        if (++pipeSpawnTimer >= pipeSpawnTicks) {
+            pipeSpawnTimer = 0;
+            spawnPipe();
+        }
+
+        // Pipe movement
+        for (uint32_t i = firstPipe; i != pipeEnd; ++i) {
+            pipe(i).x -= pipeSpeed;
+        }
+
+        // Broadphase: only pipes overlapping the bird's x range can hit it
+        const float birdLeft = BIRD_X - BIRD_SIZE / 2, birdRight = BIRD_X + BIRD_SIZE / 2;
+        for (uint32_t i = firstPipe; i != pipeEnd && pipe(i).x < birdRight; ++i) {
+            PipePair& near = pipe(i);
+            if (near.hit || near.x + PIPE_WIDTH <= birdLeft) continue;
+            if (hitsPipe(near)) {
+                events |= loseLife();
+                if (gameOver) return events;
+                near.hit = true;
+            }
+        }
+
+        // Check if bird passed the pipe
+        while (nextScore != pipeEnd && pipe(nextScore).x + PIPE_WIDTH < BIRD_X) {
+            if (!pipe(nextScore).hit) {
+                score += PIPE_POINTS;
+                events |= EVENT_POINT;
+            }
+            nextScore++;
+        }
+
+        // Remove off-screen pipes
+        while (firstPipe != nextScore && pipe(firstPipe).x + PIPE_WIDTH < 0) {
+            firstPipe++;
+        }
+        return events;
+    }
+
+    bool hitsPipe(const PipePair& pair) const {
+        float left = BIRD_X - BIRD_SIZE / 2, right = BIRD_X + BIRD_SIZE / 2;
+        float top = birdY - BIRD_SIZE / 2, bottom = birdY + BIRD_SIZE / 2;
+        return rectsOverlap(left, top, right, bottom, pair.x, 0.f, pair.x + PIPE_WIDTH, pair.gapTop) ||
+            rectsOverlap(left, top, right, bottom, pair.x, pair.gapBottom, pair.x + PIPE_WIDTH, static_cast<float>(WINDOW_HEIGHT));
+    }
+
+private:
+    void resetBird() {
+        birdY = BIRD_START_Y;
+        birdVelocity = 0.f;
+        birdRotation = 0.f;
+    }
+
+    uint8_t loseLife() {
+        lives--;
+        if (lives <= 0) {
+            gameOver = true;
+            return EVENT_LIFE_LOST | EVENT_GAME_OVER;
+        }
+        resetBird();
+        return EVENT_LIFE_LOST;
+    }
+};
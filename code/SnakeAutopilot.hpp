@@ -0,0 +1,283 @@
+#pragma once
+// Snake autopilot: plans a path to the food whenever it spawns and then follows it, for attract
+// mode, bots and load testing. Plans are only made on ticks the snake isn't moving on where it
+// can, so the tick the snake moves on just reads the next step off the path.
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include "Simulation.hpp"
+
+// Planning cost, one sample per call to next()
+struct AutopilotStats {
+    uint64_t calls;
+    uint64_t plans; // searches from the head to new food
+    uint64_t repairs; // paths patched back together after the snake left them
+    uint64_t fallbacks; // moves made without a safe path to the food
+    uint64_t totalNanos;
+    uint64_t maxNanos;
+
+    AutopilotStats() : calls(0), plans(0), repairs(0), fallbacks(0), totalNanos(0), maxNanos(0) {}
+
+    double averageMicros() const { return calls ? totalNanos / 1000.0 / calls : 0.0; }
+    double maxMicros() const { return maxNanos / 1000.0; }
+};
+
+class SnakeAutopilot {
+private:
+    static constexpr int CELLS = SnakeBoard::CELLS;
+
+    // The plan: path[0..pathLength) are the cells from just after the head the plan started at
+    // to the food, path[pathPos] is the next one to step into
+    int16_t path[CELLS];
+    int pathLength;
+    int pathPos;
+    bool planValid; // false while there is no safe path and the snake is stalling
+    int planFood; // food cell the plan was made for, -2 before the first plan
+    int expectedHead; // where the head should be if the snake is on the plan
+    uint32_t plannedVersion; // sim.bodyVersion when the plan (or the fallback) was made
+    SnakeDirection fallbackDirection;
+
+    // Ticks until the body leaves each cell, 0 when it's empty. A path may go through a body cell
+    // if the snake gets there after it's gone.
+    uint16_t freeAt[CELLS];
+    uint16_t virtualFreeAt[CELLS]; // the same for the body the snake will have once it has eaten
+
+    // Search scratch, cleared by bumping stamp rather than touching every cell
+    uint32_t seen[CELLS];
+    uint32_t stamp;
+    uint16_t distance[CELLS];
+    int16_t parent[CELLS];
+    int16_t queue[CELLS];
+    int visited; // cells reached by the last search
+    uint32_t pathMark[CELLS]; // pathStamp for cells on the rest of the path during a repair
+    uint32_t pathStamp;
+    int16_t pathIndex[CELLS];
+    int16_t spliced[CELLS];
+
+    AutopilotStats stats;
+
+    static int cellX(int cell) { return cell % SNAKE_COLS; }
+    static int cellY(int cell) { return cell / SNAKE_COLS; }
+
+    static SnakeDirection directionTo(int from, int to) {
+        int dx = cellX(to) - cellX(from);
+        if (dx == 1) return DIR_RIGHT;
+        if (dx == -1) return DIR_LEFT;
+        return cellY(to) > cellY(from) ? DIR_DOWN : DIR_UP;
+    }
+
+    static void bodyFreeAt(const SnakeSim& sim, uint16_t* out) {
+        std::memset(out, 0, sizeof(uint16_t) * CELLS);
+        // tail first, so a cell under two segments keeps the later time
+        for (int i = sim.length - 1; i >= 0; --i) {
+            const SnakeCell& segment = sim.segment(i);
+            if (SnakeBoard::inBounds(segment.x, segment.y)) out[SnakeBoard::index(segment.x, segment.y)] = static_cast<uint16_t>(sim.length - i);
+        }
+    }
+
+    //breadth-first search from start, which the snake reaches after startDistance moves heading
+    //the given way. Returns the first cell isTarget accepts (parent[] leads back), or -1
+    template <typename Target>
+    int search(const uint16_t* bodyFree, int start, SnakeDirection heading, int startDistance, Target isTarget) {
+        if (++stamp == 0) {
+            std::memset(seen, 0, sizeof(seen));
+            stamp = 1;
+        }
+        seen[start] = stamp;
+        distance[start] = static_cast<uint16_t>(startDistance);
+        parent[start] = -1;
+        int front = 0, back = 0;
+        queue[back++] = static_cast<int16_t>(start);
+        while (front < back) {
+            int cell = queue[front++];
+            int arrival = distance[cell] + 1;
+            for (int h = 0; h < 4; ++h) {
+                SnakeDirection direction = static_cast<SnakeDirection>(h);
+                if (cell == start && h == (heading + 2) % 4) continue; // can't turn back on itself
+                int x = cellX(cell) + directionX(direction), y = cellY(cell) + directionY(direction);
+                if (!SnakeBoard::inBounds(x, y)) continue;
+                int next = SnakeBoard::index(x, y);
+                // still under the body when the head gets there, a later arrival may find it gone
+                if (seen[next] == stamp || bodyFree[next] > arrival) continue;
+                seen[next] = stamp;
+                distance[next] = static_cast<uint16_t>(arrival);
+                parent[next] = static_cast<int16_t>(cell);
+                if (isTarget(next)) {
+                    visited = back;
+                    return next;
+                }
+                queue[back++] = static_cast<int16_t>(next);
+            }
+        }
+        visited = back;
+        return -1;
+    }
+
+    //writes the parent chain from start to end into out, returns its length (start not included)
+    int tracePath(int start, int end, int16_t* out) const {
+        int count = 0;
+        for (int cell = end; cell != start; cell = parent[cell]) count++;
+        int i = count;
+        for (int cell = end; cell != start; cell = parent[cell]) out[--i] = static_cast<int16_t>(cell);
+        return count;
+    }
+
+    //whether the snake can still get back to its tail after following the path and eating,
+    //so taking the food never traps it in a pocket of its own body
+    bool tailReachableAfterPath(const SnakeSim& sim) {
+        int grown = sim.length + 1;
+        std::memset(virtualFreeAt, 0, sizeof(virtualFreeAt));
+        // the body after pathLength moves, head first: the path backwards, then the old body
+        int tail = -1;
+        for (int i = grown - 1; i >= 0; --i) {
+            int source = std::min(i, sim.length - 1); // eating doubles the tail segment up
+            int cell;
+            if (source < pathLength) cell = path[pathLength - 1 - source];
+            else {
+                const SnakeCell& segment = sim.segment(source - pathLength);
+                cell = SnakeBoard::index(segment.x, segment.y);
+            }
+            if (i == grown - 1) tail = cell;
+            virtualFreeAt[cell] = static_cast<uint16_t>(grown - i);
+        }
+        int food = path[pathLength - 1];
+        int before = pathLength >= 2 ? path[pathLength - 2] : SnakeBoard::index(sim.segment(0).x, sim.segment(0).y);
+        return search(virtualFreeAt, food, directionTo(before, food), 0, [tail](int cell) { return cell == tail; }) >= 0;
+    }
+
+    //the move to make while there's no safe path: towards the tail the long way round if it can
+    //be reached, otherwise into the biggest open area
+    SnakeDirection chooseFallback(const SnakeSim& sim, int head) {
+        const SnakeCell& tailSegment = sim.segment(sim.length - 1);
+        int tail = SnakeBoard::index(tailSegment.x, tailSegment.y);
+        SnakeDirection best = sim.direction;
+        int bestScore = -1;
+        for (int h = 0; h < 4; ++h) {
+            SnakeDirection direction = static_cast<SnakeDirection>(h);
+            if (h == (sim.direction + 2) % 4) continue;
+            int x = cellX(head) + directionX(direction), y = cellY(head) + directionY(direction);
+            if (!SnakeBoard::inBounds(x, y)) continue;
+            int next = SnakeBoard::index(x, y);
+            if (freeAt[next] > 1) continue;
+            int found = search(freeAt, next, direction, 1, [tail](int cell) { return cell == tail; });
+            // reaching the tail beats any open area, and further away stalls for longer
+            int score = found >= 0 ? CELLS + distance[found] : visited;
+            if (score > bestScore) {
+                bestScore = score;
+                best = direction;
+            }
+        }
+        return best;
+    }
+
+    void plan(const SnakeSim& sim, int head, int food) {
+        stats.plans++;
+        bodyFreeAt(sim, freeAt);
+        planFood = food;
+        plannedVersion = sim.bodyVersion;
+        expectedHead = head;
+        pathPos = 0;
+        pathLength = 0;
+        planValid = false;
+        if (food >= 0) {
+            int found = search(freeAt, head, sim.direction, 0, [food](int cell) { return cell == food; });
+            if (found >= 0) {
+                pathLength = tracePath(head, found, path);
+                planValid = tailReachableAfterPath(sim);
+            }
+        }
+        if (!planValid) fallbackDirection = chooseFallback(sim, head);
+    }
+
+    //the head is off the path (a life was lost, or someone else was steering): search outwards
+    //from the head for the nearest cell on the rest of the path and join it there, replanning
+    //from scratch only if there's no such cell or the joined path runs into the body
+    void repair(const SnakeSim& sim, int head) {
+        bodyFreeAt(sim, freeAt);
+        if (++pathStamp == 0) {
+            std::memset(pathMark, 0, sizeof(pathMark));
+            pathStamp = 1;
+        }
+        uint32_t mark = pathStamp;
+        for (int i = pathPos; i < pathLength; ++i) {
+            pathMark[path[i]] = mark;
+            pathIndex[path[i]] = static_cast<int16_t>(i);
+        }
+        int found = search(freeAt, head, sim.direction, 0, [&](int cell) { return pathMark[cell] == mark; });
+        if (found >= 0) {
+            int length = tracePath(head, found, spliced);
+            for (int i = pathIndex[found] + 1; i < pathLength; ++i) spliced[length++] = path[i];
+            bool clear = true;
+            for (int i = 0; i < length && clear; ++i) clear = freeAt[spliced[i]] <= i + 1;
+            if (clear) {
+                std::memcpy(path, spliced, sizeof(int16_t) * length);
+                pathLength = length;
+                pathPos = 0;
+                expectedHead = head;
+                plannedVersion = sim.bodyVersion;
+                stats.repairs++;
+                return;
+            }
+        }
+        plan(sim, head, planFood);
+    }
+
+    uint8_t decide(const SnakeSim& sim) {
+        if (sim.gameOver) return INPUT_NONE;
+        const SnakeCell& headSegment = sim.segment(0);
+        if (!SnakeBoard::inBounds(headSegment.x, headSegment.y)) return INPUT_NONE;
+        int head = SnakeBoard::index(headSegment.x, headSegment.y);
+        int food = sim.foodX < 0 ? -1 : SnakeBoard::index(sim.foodX, sim.foodY);
+
+        // Keep the plan current every tick, so the work lands on the ticks between moves
+        if (planValid && pathPos < pathLength && head == path[pathPos]) {
+            expectedHead = head; // moved along the plan
+            pathPos++;
+        }
+        if (food != planFood || (!planValid && sim.bodyVersion != plannedVersion) || (planValid && pathPos >= pathLength)) {
+            plan(sim, head, food);
+        }
+        else if (planValid && head != expectedHead) {
+            repair(sim, head);
+        }
+
+        if (sim.moveTimer + 1 < sim.moveTicks) return INPUT_NONE; // only steer on the tick the snake moves
+        SnakeDirection direction = fallbackDirection;
+        if (planValid) {
+            direction = directionTo(head, path[pathPos]);
+        }
+        else {
+            stats.fallbacks++;
+        }
+        return direction == sim.direction ? static_cast<uint8_t>(INPUT_NONE) : directionInput(direction);
+    }
+
+public:
+    SnakeAutopilot() : pathLength(0), pathPos(0), planValid(false), planFood(-2), expectedHead(-1),
+        plannedVersion(0), fallbackDirection(DIR_UP), stamp(0), visited(0), pathStamp(0) {
+        std::memset(seen, 0, sizeof(seen));
+        std::memset(pathMark, 0, sizeof(pathMark));
+    }
+
+    //the input for sim's next tick, call it every tick
+    uint8_t next(const SnakeSim& sim) {
+        auto start = std::chrono::steady_clock::now();
+        uint8_t input = decide(sim);
+        uint64_t nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        stats.calls++;
+        stats.totalNanos += nanos;
+        stats.maxNanos = std::max(stats.maxNanos, nanos);
+        return input;
+    }
+
+    //forgets the plan, e.g. when the round restarts
+    void clear() {
+        planFood = -2;
+        planValid = false;
+        pathLength = pathPos = 0;
+    }
+
+    const AutopilotStats& getStats() const { return stats; }
+    void resetStats() { stats = AutopilotStats(); }
+};
@@ -0,0 +1,316 @@
+#pragma once
+// Bot tournaments: every bot plays one whole round on each of many seeds, headless, on a
+// work-stealing thread pool. Each thread keeps its own statistics, so nothing is locked or shared
+// while matches run; they are merged once the threads are done.
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstdint>
+#include "Simulation.hpp"
+#include "Replay.hpp"
+#include "SnakeAutopilot.hpp"
+
+const uint64_t TOURNAMENT_MAX_TICKS = 10 * 60 * SIM_TICKS_PER_SECOND; // a round still going after 10 minutes is stopped there
+const uint64_t SURVIVAL_BUCKET_TICKS = SIM_TICKS_PER_SECOND; // survival lengths are binned by the second
+
+//flaps whenever the bird sinks below the middle of the next gap
+inline uint8_t flappyAutopilot(const FlappySim& sim) {
+    float target = BIRD_START_Y;
+    for (uint32_t i = sim.firstPipe; i != sim.pipeEnd; ++i) {
+        const PipePair& pipe = sim.pipe(i);
+        if (!pipe.hit && pipe.x + PIPE_WIDTH > BIRD_X - BIRD_SIZE / 2) {
+            target = pipe.gapTop + PIPE_GAP * 0.6f;
+            break;
+        }
+    }
+    return (sim.birdY > target && sim.birdVelocity > 0) ? INPUT_FLAP : INPUT_NONE;
+}
+
+// Something that plays a game. Each thread gets its own instance, and start() is called before
+// every round so a bot can keep state between ticks.
+class Bot {
+public:
+    virtual ~Bot() {}
+    virtual void start(uint64_t) {}
+    virtual uint8_t snake(const SnakeSim&) { return INPUT_NONE; }
+    virtual uint8_t flappy(const FlappySim&) { return INPUT_NONE; }
+};
+
+// Turns at random now and then, or flaps at random
+class RandomBot : public Bot {
+private:
+    SimRandom rng;
+
+public:
+    void start(uint64_t seed) override { rng.reseed(seed ^ 0x9e3779b97f4a7c15ull); }
+
+    uint8_t snake(const SnakeSim& sim) override {
+        if (sim.moveTimer + 1 < sim.moveTicks || rng.below(4) != 0) return INPUT_NONE;
+        return directionInput(static_cast<SnakeDirection>(rng.below(4)));
+    }
+
+    uint8_t flappy(const FlappySim&) override { return rng.below(12) == 0 ? INPUT_FLAP : INPUT_NONE; }
+};
+
+// Takes whichever safe step gets closest to the food
+class GreedySnakeBot : public Bot {
+public:
+    uint8_t snake(const SnakeSim& sim) override {
+        // only steer on the tick the snake moves, two turns before one move could double it back
+        if (sim.moveTimer + 1 < sim.moveTicks) return INPUT_NONE;
+        const SnakeCell& head = sim.segment(0);
+        const SnakeCell& tail = sim.segment(sim.length - 1);
+        int best = -1, bestDistance = INT_MAX;
+        for (int heading = 0; heading < 4; ++heading) {
+            if (heading == (sim.direction + 2) % 4) continue;
+            SnakeDirection direction = static_cast<SnakeDirection>(heading);
+            int x = head.x + directionX(direction), y = head.y + directionY(direction);
+            if (!SnakeBoard::inBounds(x, y)) continue;
+            // the tail moves out of the way first, unless the snake just grew onto it
+            bool tailLeaving = x == tail.x && y == tail.y && sim.board.segments[SnakeBoard::index(x, y)] == 1;
+            if (sim.board.isOccupied(x, y) && !tailLeaving) continue;
+            int distance = sim.foodX < 0 ? 0 : std::abs(sim.foodX - x) + std::abs(sim.foodY - y);
+            if (distance < bestDistance || (distance == bestDistance && direction == sim.direction)) {
+                best = heading;
+                bestDistance = distance;
+            }
+        }
+        if (best < 0 || best == sim.direction) return INPUT_NONE;
+        return directionInput(static_cast<SnakeDirection>(best));
+    }
+};
+
+class SnakeAutopilotBot : public Bot {
+private:
+    SnakeAutopilot pilot;
+
+public:
+    void start(uint64_t) override { pilot.clear(); }
+    uint8_t snake(const SnakeSim& sim) override { return pilot.next(sim); }
+};
+
+class FlappyAutopilotBot : public Bot {
+public:
+    uint8_t flappy(const FlappySim& sim) override { return flappyAutopilot(sim); }
+};
+
+struct BotEntry {
+    std::string name;
+    GameKind game;
+    std::function<std::unique_ptr<Bot>()> make;
+};
+
+inline std::vector<BotEntry> tournamentBots() {
+    return {
+        { "random", GAME_SNAKE, [] { return std::unique_ptr<Bot>(new RandomBot()); } },
+        { "greedy", GAME_SNAKE, [] { return std::unique_ptr<Bot>(new GreedySnakeBot()); } },
+        { "autopilot", GAME_SNAKE, [] { return std::unique_ptr<Bot>(new SnakeAutopilotBot()); } },
+        { "random", GAME_FLAPPY, [] { return std::unique_ptr<Bot>(new RandomBot()); } },
+        { "autopilot", GAME_FLAPPY, [] { return std::unique_ptr<Bot>(new FlappyAutopilotBot()); } },
+    };
+}
+
+// One bot's results. Scores and survival lengths are counted per value (survival per second)
+// so the distributions merge exactly whichever thread played which match.
+struct BotStats {
+    uint64_t matches;
+    uint64_t capped; // rounds stopped at TOURNAMENT_MAX_TICKS
+    uint64_t totalScore;
+    uint64_t totalTicks;
+    std::vector<uint64_t> scores; // matches ending on each score
+    std::vector<uint64_t> survival; // matches lasting each number of seconds
+
+    BotStats() : matches(0), capped(0), totalScore(0), totalTicks(0) {}
+
+    void add(int score, uint64_t ticks, bool cap) {
+        matches++;
+        capped += cap;
+        totalScore += score;
+        totalTicks += ticks;
+        size_t scoreBin = static_cast<size_t>(std::max(score, 0));
+        size_t survivalBin = static_cast<size_t>(ticks / SURVIVAL_BUCKET_TICKS);
+        if (scoreBin >= scores.size()) scores.resize(scoreBin + 1);
+        if (survivalBin >= survival.size()) survival.resize(survivalBin + 1);
+        scores[scoreBin]++;
+        survival[survivalBin]++;
+    }
+
+    void merge(const BotStats& other) {
+        matches += other.matches;
+        capped += other.capped;
+        totalScore += other.totalScore;
+        totalTicks += other.totalTicks;
+        if (other.scores.size() > scores.size()) scores.resize(other.scores.size());
+        if (other.survival.size() > survival.size()) survival.resize(other.survival.size());
+        for (size_t i = 0; i < other.scores.size(); ++i) scores[i] += other.scores[i];
+        for (size_t i = 0; i < other.survival.size(); ++i) survival[i] += other.survival[i];
+    }
+
+    //the bin fraction of the matches are at or below, e.g. 0.5 for the median
+    static size_t percentile(const std::vector<uint64_t>& counts, uint64_t total, double fraction) {
+        uint64_t rank = static_cast<uint64_t>(fraction * (total ? total - 1 : 0));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen > rank) return i;
+        }
+        return counts.empty() ? 0 : counts.size() - 1;
+    }
+
+    int scorePercentile(double fraction) const { return static_cast<int>(percentile(scores, matches, fraction)); }
+    int survivalPercentile(double fraction) const { return static_cast<int>(percentile(survival, matches, fraction)); } // seconds
+    double meanScore() const { return matches ? static_cast<double>(totalScore) / matches : 0.0; }
+    double meanSurvival() const { return matches ? static_cast<double>(totalTicks) / matches / SIM_TICKS_PER_SECOND : 0.0; }
+
+    bool operator==(const BotStats& other) const {
+        return matches == other.matches && capped == other.capped && totalScore == other.totalScore &&
+            totalTicks == other.totalTicks && scores == other.scores && survival == other.survival;
+    }
+};
+
+// Job numbers handed out by work stealing. Each worker owns a range packed into one atomic word,
+// (end << 32) | next: the owner takes jobs from the front, and a worker that runs dry takes the
+// back half of another's range. Both sides move the range with a compare-exchange, so no locks.
+class StealingRanges {
+private:
+    struct alignas(64) Range {
+        std::atomic<uint64_t> bounds;
+    };
+
+    std::vector<Range> ranges;
+    std::atomic<uint32_t> unclaimed; // jobs nobody has taken yet, workers stop when it reaches 0
+    std::atomic<uint64_t> steals;
+
+    static uint64_t pack(uint32_t next, uint32_t end) { return static_cast<uint64_t>(end) << 32 | next; }
+    static uint32_t nextOf(uint64_t bounds) { return static_cast<uint32_t>(bounds); }
+    static uint32_t endOf(uint64_t bounds) { return static_cast<uint32_t>(bounds >> 32); }
+
+    bool takeOwn(size_t worker, uint32_t& job) {
+        std::atomic<uint64_t>& bounds = ranges[worker].bounds;
+        uint64_t seen = bounds.load(std::memory_order_acquire);
+        while (nextOf(seen) < endOf(seen)) {
+            if (bounds.compare_exchange_weak(seen, pack(nextOf(seen) + 1, endOf(seen)), std::memory_order_acq_rel)) {
+                job = nextOf(seen);
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    //jobs 0..jobs-1 split evenly between the workers to start with
+    StealingRanges(size_t workers, uint32_t jobs) : ranges(workers), unclaimed(jobs), steals(0) {
+        for (size_t worker = 0; worker < workers; ++worker) {
+            uint32_t begin = static_cast<uint32_t>(jobs * worker / workers);
+            uint32_t end = static_cast<uint32_t>(jobs * (worker + 1) / workers);
+            ranges[worker].bounds.store(pack(begin, end), std::memory_order_relaxed);
+        }
+    }
+
+    //the next job for worker, false once every job has been taken
+    bool take(size_t worker, uint32_t& job) {
+        for (;;) {
+            if (takeOwn(worker, job)) {
+                unclaimed.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+            for (size_t offset = 1; offset < ranges.size(); ++offset) {
+                std::atomic<uint64_t>& victim = ranges[(worker + offset) % ranges.size()].bounds;
+                uint64_t seen = victim.load(std::memory_order_acquire);
+                uint32_t next = nextOf(seen), end = endOf(seen);
+                if (next >= end) continue;
+                uint32_t middle = next + (end - next) / 2; // the victim keeps [next, middle)
+                if (victim.compare_exchange_strong(seen, pack(next, middle), std::memory_order_acq_rel)) {
+                    ranges[worker].bounds.store(pack(middle + 1, end), std::memory_order_release);
+                    steals.fetch_add(1, std::memory_order_relaxed);
+                    unclaimed.fetch_sub(1, std::memory_order_relaxed);
+                    job = middle;
+                    return true;
+                }
+            }
+            // everything left may be in a range a thief is about to publish
+            if (unclaimed.load(std::memory_order_relaxed) == 0) return false;
+            std::this_thread::yield();
+        }
+    }
+
+    uint64_t getSteals() const { return steals.load(std::memory_order_relaxed); }
+};
+
+struct TournamentResult {
+    std::vector<BotStats> bots; // in the order they were entered
+    uint64_t matches;
+    uint64_t ticks;
+    uint64_t steals;
+    int threads;
+    double seconds;
+};
+
+//every bot plays seedCount rounds, on seeds firstSeed onwards, spread over threads threads
+inline TournamentResult runTournament(const std::vector<BotEntry>& bots, uint32_t seedCount, uint64_t firstSeed, int threads) {
+    threads = std::max(threads, 1);
+    uint32_t jobs = static_cast<uint32_t>(bots.size()) * seedCount;
+    StealingRanges ranges(static_cast<size_t>(threads), jobs);
+
+    // touched only by its own thread until join, padded so neighbours don't share a cache line
+    struct alignas(64) Accumulator {
+        std::vector<BotStats> bots;
+    };
+    std::vector<Accumulator> accumulators(static_cast<size_t>(threads));
+
+    auto worker = [&](size_t index) {
+        Accumulator& accumulator = accumulators[index];
+        accumulator.bots.resize(bots.size());
+        std::vector<std::unique_ptr<Bot>> players;
+        for (const auto& entry : bots) players.push_back(entry.make());
+        std::unique_ptr<SnakeSim> snake(new SnakeSim());
+        std::unique_ptr<FlappySim> flappy(new FlappySim());
+
+        uint32_t job;
+        while (ranges.take(index, job)) {
+            size_t botIndex = job / seedCount;
+            uint64_t seed = firstSeed + job % seedCount;
+            Bot& bot = *players[botIndex];
+            bot.start(seed);
+            int score;
+            uint64_t ticks;
+            bool over;
+            if (bots[botIndex].game == GAME_SNAKE) {
+                snake->reset(seed);
+                while (!snake->gameOver && snake->ticks < TOURNAMENT_MAX_TICKS) snake->step(bot.snake(*snake));
+                score = snake->score;
+                ticks = snake->ticks;
+                over = snake->gameOver;
+            }
+            else {
+                flappy->reset(seed);
+                while (!flappy->gameOver && flappy->ticks < TOURNAMENT_MAX_TICKS) flappy->step(bot.flappy(*flappy));
+                score = flappy->score;
+                ticks = flappy->ticks;
+                over = flappy->gameOver;
+            }
+            accumulator.bots[botIndex].add(score, ticks, !over);
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t) pool.emplace_back(worker, static_cast<size_t>(t));
+    worker(0);
+    for (auto& thread : pool) thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    TournamentResult result = { std::vector<BotStats>(bots.size()), jobs, 0, ranges.getSteals(), threads, std::max(seconds, 1e-9) };
+    for (const auto& accumulator : accumulators) {
+        for (size_t bot = 0; bot < accumulator.bots.size(); ++bot) result.bots[bot].merge(accumulator.bots[bot]);
+    }
+    for (const auto& stats : result.bots) result.ticks += stats.totalTicks;
+    return result;
+}
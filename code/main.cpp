@@ -1,6 +1,7 @@
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
 #include <vector>
+#include <array>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -8,710 +9,1670 @@
 #include <random>
 #include <memory>
 #include <cmath>
+#include <map>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <iomanip>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <set>
+#include <ctime>
+#include <functional>
+#include "Simulation.hpp"
+#include "Replay.hpp"
+#include "Leaderboard.hpp"
+#include "Profiler.hpp"
+#include "AssetArchive.hpp"
+#include "FlappyBatch.hpp"
+#include "Tournament.hpp"
+#include "SnakeAutopilot.hpp"
+
+// Every heap allocation in the process is counted so frames can be checked for allocating
+static std::atomic<uint64_t> heapAllocations(0);
+
+void* operator new(std::size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
 
 //Declaring  Constants
-const int WINDOW_WIDTH = 1000; //defining window width
-const int WINDOW_HEIGHT = 800; //defining window height
-const std::string SNAKE_HIGHSCORE_FILE = "snake_highscores.txt"; 
+const std::string SNAKE_HIGHSCORE_FILE = "snake_highscores.txt"; // old single-score files, imported once
 const std::string FLAPPY_HIGHSCORE_FILE = "flappy_highscores.txt";
+const std::string SNAKE_LEADERBOARD = "snake_scores"; // leaderboard log and snapshot base names
+const std::string FLAPPY_LEADERBOARD = "flappy_scores";
+const size_t LEADERBOARD_SIZE = 10;
 const std::string MUTE_TEXT = "Music: T to toggle";
+const float ATTRACT_IDLE_SECONDS = 30.f; // the menu starts a self-playing snake game after this long without a key press
+
+// Assets are named relative to the asset root, which is either a packed archive or a directory
+// of loose files (see AssetCache::setAssetRoot)
+const std::string ASSET_ARCHIVE_NAME = "assets.pak";
+
+// Font path
+const std::string ARCADE_FONT = "ARCADE_R.TTF";
 
 // Texture paths
-const std::string MENU_BACKGROUND = "D:/happy/mycode/Assets/Images/mainbackground.png";
-const std::string SNAKE_BACKGROUND = "D:/happy/mycode/Assets/Images/snakebackground.png";
-const std::string FLAPPY_BACKGROUND = "D:/happy/mycode/Assets/Images/flappybirdbackground.png";
+const std::string MENU_BACKGROUND = "mainbackground.png";
+const std::string SNAKE_BACKGROUND = "snakebackground.png";
+const std::string FLAPPY_BACKGROUND = "flappybirdbackground.jpg";
 //bird texture
-const std::string BIRD_TEXTURE = "D:/happy/mycode/Assets/Images/basimbird.png";
+const std::string BIRD_TEXTURE = "basimbird.png";
 //sound paths
-const std::string GAME_OVER_SOUND = "D:/happy/mycode/Assets/Audio/gameover.wav";
-const std::string POINT_SOUND = "D:/happy/mycode/Assets/Audio/eat.wav";
-const std::string BG_MUSIC = "D:/happy/mycode/Assets/Audio/bgMusic.wav";
+const std::string GAME_OVER_SOUND = "gameover.wav";
+const std::string POINT_SOUND = "eat.wav";
+const std::string BG_MUSIC = "bgMusic.wav";
 
 // Snake game textures
-const std::string SNAKE_BODY_TEXTURE = "D:/happy/mycode/Assets/Images/snakebody.png";
-const std::string SNAKE_FOOD_TEXTURE = "D:/happy/mycode/Assets/Images/food.png";
+const std::string SNAKE_BODY_TEXTURE = "snakebody.png";
+const std::string SNAKE_FOOD_TEXTURE = "food.png";
+const std::string SPRITE_ATLAS = "sprites"; // built at load time from ATLAS_SPRITES, not a file
+
+// Backgrounds are textures resampled to the window size once, instead of scaled on every draw
+enum AssetKind { ASSET_FONT, ASSET_TEXTURE, ASSET_SOUND, ASSET_ATLAS, ASSET_BACKGROUND };
+
+struct AssetRef {
+    std::string path;
+    AssetKind kind;
+};
+
+// What each screen needs before it can be shown
+const std::vector<AssetRef> MENU_ASSETS = { { ARCADE_FONT, ASSET_FONT }, { MENU_BACKGROUND, ASSET_BACKGROUND } };
+const std::vector<AssetRef> SNAKE_ASSETS = { { ARCADE_FONT, ASSET_FONT }, { SNAKE_BACKGROUND, ASSET_BACKGROUND },
+    { SPRITE_ATLAS, ASSET_ATLAS },
+    { GAME_OVER_SOUND, ASSET_SOUND }, { POINT_SOUND, ASSET_SOUND } };
+const std::vector<AssetRef> FLAPPY_ASSETS = { { ARCADE_FONT, ASSET_FONT }, { FLAPPY_BACKGROUND, ASSET_BACKGROUND },
+    { SPRITE_ATLAS, ASSET_ATLAS }, { GAME_OVER_SOUND, ASSET_SOUND }, { POINT_SOUND, ASSET_SOUND } };
+
+// The small sprites share one texture so a scene binds it once rather than once per sprite
+const std::vector<std::string> ATLAS_SPRITES = { SNAKE_BODY_TEXTURE, SNAKE_FOOD_TEXTURE, BIRD_TEXTURE };
+const unsigned ATLAS_WIDTH = 1024;
+const unsigned ATLAS_PADDING = 2; // transparent gap so neighbours never bleed into each other
+
+struct SpriteAtlas {
+    sf::Texture texture;
+    std::map<std::string, sf::IntRect> rects; // where each sprite sits in the texture
+
+    //the sprite's sub-rect, empty if it failed to load
+    sf::IntRect rect(const std::string& name) const {
+        auto found = rects.find(name);
+        return found == rects.end() ? sf::IntRect() : found->second;
+    }
+
+    //shelf packs the images tallest first, left to right, starting a new row when one is full
+    static void pack(const std::vector<std::pair<std::string, sf::Image>>& sprites, sf::Image& out, std::map<std::string, sf::IntRect>& rects) {
+        std::vector<size_t> order(sprites.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&sprites](size_t a, size_t b) {
+            return sprites[a].second.getSize().y > sprites[b].second.getSize().y;
+        });
+
+        unsigned x = ATLAS_PADDING, y = ATLAS_PADDING, rowHeight = 0, width = ATLAS_WIDTH;
+        for (size_t i : order) {
+            sf::Vector2u size = sprites[i].second.getSize();
+            width = std::max(width, size.x + 2 * ATLAS_PADDING);
+            if (x + size.x + ATLAS_PADDING > width) {
+                x = ATLAS_PADDING;
+                y += rowHeight + ATLAS_PADDING;
+                rowHeight = 0;
+            }
+            rects[sprites[i].first] = sf::IntRect(static_cast<int>(x), static_cast<int>(y), static_cast<int>(size.x), static_cast<int>(size.y));
+            x += size.x + ATLAS_PADDING;
+            rowHeight = std::max(rowHeight, size.y);
+        }
+
+        out.create(width, y + rowHeight + ATLAS_PADDING, sf::Color::Transparent);
+        for (const auto& sprite : sprites) {
+            const sf::IntRect& rect = rects[sprite.first];
+            out.copy(sprite.second, static_cast<unsigned>(rect.left), static_cast<unsigned>(rect.top));
+        }
+    }
+};
+
+// Source pixels feeding each destination pixel along one axis, with their weights
+inline std::vector<std::vector<std::pair<unsigned, float>>> resampleWeights(unsigned from, unsigned to) {
+    std::vector<std::vector<std::pair<unsigned, float>>> weights(to);
+    float scale = static_cast<float>(from) / to;
+    for (unsigned i = 0; i < to; ++i) {
+        if (scale > 1.f) {
+            // shrinking: average every source pixel the destination pixel covers, partial ones by coverage
+            float start = i * scale, end = start + scale;
+            for (unsigned source = static_cast<unsigned>(start); source < from && source < end; ++source) {
+                float cover = std::min(end, source + 1.f) - std::max(start, static_cast<float>(source));
+                if (cover > 0.f) weights[i].push_back({ source, cover / scale });
+            }
+        }
+        else {
+            // growing: linear between the two nearest source pixels
+            float center = std::min(std::max((i + 0.5f) * scale - 0.5f, 0.f), static_cast<float>(from - 1));
+            unsigned source = static_cast<unsigned>(center);
+            float t = center - source;
+            weights[i].push_back({ source, 1.f - t });
+            if (source + 1 < from) weights[i].push_back({ source + 1, t });
+        }
+    }
+    return weights;
+}
+
+//resamples source to size, box filtered when shrinking and bilinear when growing, one axis at a time
+inline void resampleImage(const sf::Image& source, sf::Vector2u size, sf::Image& out) {
+    sf::Vector2u from = source.getSize();
+    if (from.x == 0 || from.y == 0 || size.x == 0 || size.y == 0 || from == size) {
+        out = source;
+        return;
+    }
+    auto columns = resampleWeights(from.x, size.x);
+    auto rows = resampleWeights(from.y, size.y);
+    const sf::Uint8* pixels = source.getPixelsPtr();
+
+    std::vector<float> horizontal(static_cast<size_t>(from.y) * size.x * 4, 0.f);
+    for (unsigned y = 0; y < from.y; ++y) {
+        for (unsigned x = 0; x < size.x; ++x) {
+            float* to = &horizontal[(static_cast<size_t>(y) * size.x + x) * 4];
+            for (const auto& tap : columns[x]) {
+                const sf::Uint8* pixel = pixels + (static_cast<size_t>(y) * from.x + tap.first) * 4;
+                for (int c = 0; c < 4; ++c) to[c] += pixel[c] * tap.second;
+            }
+        }
+    }
+
+    std::vector<sf::Uint8> result(static_cast<size_t>(size.x) * size.y * 4);
+    for (unsigned y = 0; y < size.y; ++y) {
+        for (unsigned x = 0; x < size.x; ++x) {
+            float sum[4] = {};
+            for (const auto& tap : rows[y]) {
+                const float* pixel = &horizontal[(static_cast<size_t>(tap.first) * size.x + x) * 4];
+                for (int c = 0; c < 4; ++c) sum[c] += pixel[c] * tap.second;
+            }
+            sf::Uint8* to = &result[(static_cast<size_t>(y) * size.x + x) * 4];
+            for (int c = 0; c < 4; ++c) to[c] = static_cast<sf::Uint8>(std::min(std::max(sum[c] + 0.5f, 0.f), 255.f));
+        }
+    }
+    out.create(size.x, size.y, result.data());
+}
+
+// Process-wide asset cache so every screen and game shares one copy of each font, texture and sound.
+// Images and sounds can be decoded on worker threads; only the texture upload, which needs the GL
+// context, happens on the render thread when pump() is called.
+class AssetCache {
+private:
+    std::map<std::string, std::shared_ptr<sf::Font>> fonts;
+    std::map<std::string, std::shared_ptr<sf::Texture>> textures;
+    std::map<std::string, std::shared_ptr<sf::SoundBuffer>> soundBuffers;
+    std::shared_ptr<SpriteAtlas> atlas;
+    std::map<std::string, std::shared_ptr<sf::Texture>> backgrounds; // baked at backgroundSize
+    sf::Vector2u backgroundSize;
+    int hits;
+    int misses;
+    AssetArchive archive; // mapped for the whole run, assets load straight out of it
+    std::string assetRoot; // loose files are looked up here when there's no archive
+
+    // Background decoding. jobs and decoded are shared with the workers, pending is render thread only
+    struct DecodeJob {
+        std::string path;
+        AssetKind kind;
+        sf::Vector2u size; // backgrounds only
+    };
+    struct DecodedAsset {
+        std::string path;
+        AssetKind kind;
+        bool loaded;
+        std::unique_ptr<sf::Image> image; // textures, and the packed atlas
+        std::shared_ptr<sf::SoundBuffer> sound;
+        std::map<std::string, sf::IntRect> atlasRects;
+        sf::Vector2u size;
+    };
+    std::vector<std::thread> workers;
+    std::deque<DecodeJob> jobs;
+    std::vector<DecodedAsset> decoded;
+    std::mutex decodeMutex;
+    std::condition_variable jobReady;
+    std::condition_variable decodeDone;
+    bool stopping;
+    std::set<std::string> pending; // requested and not yet in the cache
+    int asyncRequested;
+    int asyncFinished;
+
+    AssetCache() : backgroundSize(WINDOW_WIDTH, WINDOW_HEIGHT), hits(0), misses(0), stopping(false), asyncRequested(0), asyncFinished(0) {}
+
+    ~AssetCache() {
+        {
+            std::lock_guard<std::mutex> lock(decodeMutex);
+            stopping = true;
+        }
+        jobReady.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    void decodeLoop() {
+        for (;;) {
+            DecodeJob job;
+            {
+                std::unique_lock<std::mutex> lock(decodeMutex);
+                jobReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping) return;
+                job = jobs.front();
+                jobs.pop_front();
+            }
+
+            DecodedAsset result = { job.path, job.kind, false, nullptr, nullptr, {}, job.size };
+            if (job.kind == ASSET_TEXTURE) {
+                result.image = std::make_unique<sf::Image>();
+                result.loaded = loadAsset(*result.image, job.path);
+            }
+            else if (job.kind == ASSET_ATLAS) {
+                result.image = std::make_unique<sf::Image>();
+                result.loaded = buildAtlasImage(*result.image, result.atlasRects);
+            }
+            else if (job.kind == ASSET_BACKGROUND) {
+                result.image = std::make_unique<sf::Image>();
+                result.loaded = bakeBackground(*result.image, job.path, job.size);
+            }
+            else {
+                result.sound = std::make_shared<sf::SoundBuffer>();
+                result.loaded = loadAsset(*result.sound, job.path);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(decodeMutex);
+                decoded.push_back(std::move(result));
+            }
+            decodeDone.notify_all();
+        }
+    }
+
+    //from the archive when it has the asset, without copying it out, otherwise from a loose file
+    template <typename T>
+    bool loadAsset(T& asset, const std::string& name) const {
+        if (const AssetArchive::Entry* entry = archive.find(name)) {
+            return asset.loadFromMemory(archive.data(*entry), static_cast<std::size_t>(entry->size));
+        }
+        return asset.loadFromFile(resolve(name));
+    }
+
+    //decodes ATLAS_SPRITES and packs them into one image, a sprite that fails to load gets an empty rect
+    bool buildAtlasImage(sf::Image& out, std::map<std::string, sf::IntRect>& rects) const {
+        std::vector<std::pair<std::string, sf::Image>> sprites;
+        for (const auto& name : ATLAS_SPRITES) {
+            sf::Image image;
+            if (loadAsset(image, name)) {
+                sprites.emplace_back(name, image);
+            }
+            else {
+                std::cerr << "Failed to load texture: " << name << std::endl;
+            }
+        }
+        SpriteAtlas::pack(sprites, out, rects);
+        return !sprites.empty();
+    }
+
+    bool bakeBackground(sf::Image& out, const std::string& path, sf::Vector2u size) const {
+        sf::Image source;
+        if (!loadAsset(source, path)) return false;
+        resampleImage(source, size, out);
+        return true;
+    }
+
+    //uploads into the texture already handed out when there is one, so a re-bake reaches every screen using it
+    void uploadBackground(const std::string& path, const sf::Image* image) {
+        std::shared_ptr<sf::Texture>& texture = backgrounds[path];
+        if (!texture) texture = std::make_shared<sf::Texture>();
+        if (!image || !texture->loadFromImage(*image)) {
+            std::cerr << "Failed to load texture: " << path << std::endl;
+        }
+    }
+
+    void queueJob(const std::string& path, AssetKind kind) {
+        pending.insert(path);
+        asyncRequested++;
+        std::lock_guard<std::mutex> lock(decodeMutex);
+        jobs.push_back({ path, kind, backgroundSize });
+    }
+
+    void startWorkers() {
+        if (workers.empty()) {
+            unsigned count = std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+            for (unsigned i = 0; i < count; ++i) {
+                workers.emplace_back(&AssetCache::decodeLoop, this);
+            }
+        }
+        jobReady.notify_all();
+    }
+
+    std::shared_ptr<SpriteAtlas> uploadAtlas(const sf::Image& image, std::map<std::string, sf::IntRect>& rects) {
+        auto uploaded = std::make_shared<SpriteAtlas>();
+        if (!uploaded->texture.loadFromImage(image)) {
+            std::cerr << "Failed to upload sprite atlas" << std::endl;
+        }
+        uploaded->rects.swap(rects);
+        return uploaded;
+    }
+
+    //blocks until a requested asset has been decoded, for code that needs it right now
+    void waitFor(const std::string& path) {
+        while (pending.count(path)) {
+            {
+                std::unique_lock<std::mutex> lock(decodeMutex);
+                decodeDone.wait(lock, [this] { return !decoded.empty(); });
+            }
+            pump();
+        }
+    }
+
+    //looks the path up in the given store and only goes to disk the first time it is asked for
+    template <typename T>
+    std::shared_ptr<const T> acquire(std::map<std::string, std::shared_ptr<T>>& store, const std::string& path, const char* kind) {
+        auto found = store.find(path);
+        if (found != store.end()) {
+            hits++;
+            return found->second;
+        }
+
+        misses++;
+        auto asset = std::make_shared<T>();
+        if (!loadAsset(*asset, path)) {
+            std::cerr << "Failed to load " << kind << ": " << path << std::endl;
+        }
+        // failed loads are cached too so a missing file is not retried on every switch
+        store[path] = asset;
+        return asset;
+    }
+
+    template <typename T>
+    static void dropUnused(std::map<std::string, std::shared_ptr<T>>& store) {
+        for (auto it = store.begin(); it != store.end(); ) {
+            if (it->second.use_count() == 1) {
+                it = store.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+public:
+    AssetCache(const AssetCache&) = delete;
+    AssetCache& operator=(const AssetCache&) = delete;
+
+    static AssetCache& instance() {
+        static AssetCache cache;
+        return cache;
+    }
+
+    //points the cache at a packed archive or a directory of loose files, false if it's neither
+    bool setAssetRoot(const std::string& path) {
+        std::error_code error;
+        if (std::filesystem::is_directory(path, error)) {
+            archive.close();
+            assetRoot = path;
+            return true;
+        }
+        if (archive.open(path)) {
+            assetRoot = std::filesystem::path(path).parent_path().string();
+            return true;
+        }
+        return false;
+    }
+
+    //without --assets: $ARCADE_ASSETS, then an assets.pak or an Assets folder next to the working
+    //directory or the executable, archive first
+    void locateAssets(const std::string& executable) {
+        if (const char* configured = std::getenv("ARCADE_ASSETS")) {
+            if (setAssetRoot(configured)) return;
+            std::cerr << "ARCADE_ASSETS is not an asset archive or directory: " << configured << std::endl;
+        }
+        std::filesystem::path bases[] = { std::filesystem::current_path(), std::filesystem::path(executable).parent_path() };
+        for (const auto& base : bases) {
+            std::error_code error;
+            if (std::filesystem::is_regular_file(base / ASSET_ARCHIVE_NAME, error) && setAssetRoot((base / ASSET_ARCHIVE_NAME).string())) return;
+            for (const char* folder : { "Assets", "code/Assets" }) {
+                if (std::filesystem::is_directory(base / folder, error)) {
+                    setAssetRoot((base / folder).string());
+                    return;
+                }
+            }
+        }
+        std::cerr << "No asset archive or Assets folder found, use --assets <path>" << std::endl;
+        assetRoot = "Assets";
+    }
+
+    std::string resolve(const std::string& name) const {
+        return (std::filesystem::path(assetRoot) / name).string();
+    }
+
+    //music streams for as long as it plays, from the mapping or the file
+    bool openMusic(sf::Music& music, const std::string& name) const {
+        if (const AssetArchive::Entry* entry = archive.find(name)) {
+            return music.openFromMemory(archive.data(*entry), static_cast<std::size_t>(entry->size));
+        }
+        return music.openFromFile(resolve(name));
+    }
+
+    std::shared_ptr<const sf::Font> getFont(const std::string& path) {
+        return acquire(fonts, path, "font");
+    }
+
+    std::shared_ptr<const sf::Texture> getTexture(const std::string& path) {
+        waitFor(path);
+        return acquire(textures, path, "texture");
+    }
+
+    std::shared_ptr<const sf::SoundBuffer> getSoundBuffer(const std::string& path) {
+        waitFor(path);
+        return acquire(soundBuffers, path, "sound");
+    }
+
+    //the snake, food and bird sprites packed into one texture
+    std::shared_ptr<const SpriteAtlas> getAtlas() {
+        waitFor(SPRITE_ATLAS);
+        if (atlas) {
+            hits++;
+            return atlas;
+        }
+        misses++;
+        sf::Image image;
+        std::map<std::string, sf::IntRect> rects;
+        buildAtlasImage(image, rects);
+        atlas = uploadAtlas(image, rects);
+        return atlas;
+    }
+
+    //a background image resampled to the window size, shared by every screen that shows it
+    std::shared_ptr<const sf::Texture> getBackground(const std::string& path) {
+        waitFor(path);
+        auto found = backgrounds.find(path);
+        if (found != backgrounds.end()) {
+            hits++;
+            return found->second;
+        }
+        misses++;
+        sf::Image image;
+        uploadBackground(path, bakeBackground(image, path, backgroundSize) ? &image : nullptr);
+        return backgrounds[path];
+    }
+
+    //call when the window is resized, every cached background is re-baked in the background and
+    //swapped into its existing texture, screens keep drawing the old one stretched until then
+    void setBackgroundSize(sf::Vector2u size) {
+        if (size == backgroundSize || size.x == 0 || size.y == 0) return;
+        backgroundSize = size;
+        bool queued = false;
+        for (const auto& background : backgrounds) {
+            if (pending.count(background.first)) continue; // pump() re-queues it when the stale one lands
+            queueJob(background.first, ASSET_BACKGROUND);
+            queued = true;
+        }
+        if (queued) startWorkers();
+    }
+
+    sf::Vector2u getBackgroundSize() const { return backgroundSize; }
+
+    //starts decoding the assets on worker threads, anything already cached or on its way is skipped
+    void loadAsync(const std::vector<AssetRef>& assets) {
+        bool queued = false;
+        for (const auto& asset : assets) {
+            if (asset.kind == ASSET_FONT) {
+                getFont(asset.path); // fonts are only opened here, glyphs are rendered on demand
+                continue;
+            }
+            bool cached = asset.kind == ASSET_ATLAS ? atlas != nullptr :
+                asset.kind == ASSET_BACKGROUND ? backgrounds.count(asset.path) > 0 :
+                asset.kind == ASSET_TEXTURE ? textures.count(asset.path) > 0 : soundBuffers.count(asset.path) > 0;
+            if (cached || pending.count(asset.path)) continue;
+
+            queueJob(asset.path, asset.kind);
+            queued = true;
+        }
+        if (queued) startWorkers();
+    }
+
+    //moves finished decodes into the cache, uploading textures, call once a frame on the render thread
+    void pump() {
+        std::vector<DecodedAsset> finished;
+        {
+            std::lock_guard<std::mutex> lock(decodeMutex);
+            finished.swap(decoded);
+        }
+        for (auto& asset : finished) {
+            if (asset.kind == ASSET_BACKGROUND && asset.size != backgroundSize) {
+                // the window was resized while this one was being baked, bake it again at the new size
+                std::lock_guard<std::mutex> lock(decodeMutex);
+                jobs.push_back({ asset.path, asset.kind, backgroundSize });
+                jobReady.notify_one();
+                continue;
+            }
+            misses++;
+            asyncFinished++;
+            pending.erase(asset.path);
+            if (asset.kind == ASSET_TEXTURE) {
+                auto texture = std::make_shared<sf::Texture>();
+                if (!asset.loaded || !texture->loadFromImage(*asset.image)) {
+                    std::cerr << "Failed to load texture: " << asset.path << std::endl;
+                }
+                textures[asset.path] = texture;
+            }
+            else if (asset.kind == ASSET_ATLAS) {
+                atlas = uploadAtlas(*asset.image, asset.atlasRects);
+            }
+            else if (asset.kind == ASSET_BACKGROUND) {
+                uploadBackground(asset.path, asset.loaded ? asset.image.get() : nullptr);
+            }
+            else {
+                if (!asset.loaded) {
+                    std::cerr << "Failed to load sound: " << asset.path << std::endl;
+                }
+                soundBuffers[asset.path] = asset.sound;
+            }
+        }
+    }
+
+    bool isLoaded(const std::vector<AssetRef>& assets) const {
+        for (const auto& asset : assets) {
+            if (pending.count(asset.path)) return false;
+        }
+        return true;
+    }
+
+    bool isIdle() const { return pending.empty(); }
+
+    //0..1 across everything requested with loadAsync so far
+    float getProgress() const {
+        return asyncRequested == 0 ? 1.f : static_cast<float>(asyncFinished) / asyncRequested;
+    }
+
+    //loads every asset the menu and both games use so the first switch is as cheap as the rest
+    void preload() {
+        loadAsync(MENU_ASSETS);
+        loadAsync(SNAKE_ASSETS);
+        loadAsync(FLAPPY_ASSETS);
+        while (!isIdle()) {
+            waitFor(*pending.begin());
+        }
+    }
+
+    //frees assets nobody outside the cache holds a reference to any more
+    void releaseUnused() {
+        dropUnused(fonts);
+        dropUnused(textures);
+        dropUnused(soundBuffers);
+        dropUnused(backgrounds);
+        if (atlas && atlas.use_count() == 1) atlas.reset();
+    }
+
+    int getHits() const { return hits; }
+    int getMisses() const { return misses; }
+    size_t getAssetCount() const { return fonts.size() + textures.size() + soundBuffers.size() + backgrounds.size() + (atlas ? 1 : 0); }
+
+    void printStats(std::ostream& out) const {
+        out << "Asset cache: " << hits << " hits, " << misses << " misses, "
+            << getAssetCount() << " assets resident" << std::endl;
+        if (archive.isOpen()) {
+            out << "Assets: " << archive.getEntryCount() << " files in one " << archive.getMappedSize() / 1024 << "KB mapped archive" << std::endl;
+        }
+        else {
+            out << "Assets: loose files from " << assetRoot << std::endl;
+        }
+        out << "Backgrounds: " << backgrounds.size() << " baked at " << backgroundSize.x << "x" << backgroundSize.y
+            << ", " << backgrounds.size() * backgroundSize.x * backgroundSize.y * 4 / 1024 << "KB of texture" << std::endl;
+    }
+};
+
+// Both games' leaderboards, read from disk once and served from memory after that
+class Leaderboards {
+private:
+    Leaderboard snake;
+    Leaderboard flappy;
+    std::string playerName;
+
+    Leaderboards() : snake(SNAKE_LEADERBOARD, LEADERBOARD_SIZE), flappy(FLAPPY_LEADERBOARD, LEADERBOARD_SIZE), playerName("PLAYER") {
+        snake.load();
+        snake.importLegacy(SNAKE_HIGHSCORE_FILE);
+        flappy.load();
+        flappy.importLegacy(FLAPPY_HIGHSCORE_FILE);
+    }
+
+public:
+    Leaderboards(const Leaderboards&) = delete;
+    Leaderboards& operator=(const Leaderboards&) = delete;
+
+    static Leaderboards& instance() {
+        static Leaderboards boards;
+        return boards;
+    }
+
+    Leaderboard& get(GameKind game) { return game == GAME_SNAKE ? snake : flappy; }
+
+    void setPlayerName(const std::string& name) { playerName = name; }
+    const std::string& getPlayerName() const { return playerName; }
+};
+
+// Render counters for the frame being drawn, reported at exit
+struct RenderStats {
+    int drawCalls; // so far this frame
+    int lastFrameDrawCalls;
+    int peakDrawCalls;
+    uint64_t totalDrawCalls;
+    uint64_t frames;
+    uint64_t allocationsAtFrameStart;
+    uint64_t lastFrameAllocations;
+    uint64_t peakAllocations;
+    uint64_t allocationFreeFrames;
+    uint64_t gameplayTicks; // simulation ticks that didn't end a round
+    uint64_t allocatingTicks; // ...of which allocated something, should stay 0 after warm-up
+    int textureBinds; // so far this frame: draws whose texture differs from the draw before
+    int lastFrameTextureBinds;
+    int peakTextureBinds;
+    uint64_t totalTextureBinds;
+    const sf::Texture* boundTexture;
+
+    static RenderStats& instance() {
+        static RenderStats stats = {};
+        return stats;
+    }
+
+    void endFrame() {
+        lastFrameDrawCalls = drawCalls;
+        peakDrawCalls = std::max(peakDrawCalls, drawCalls);
+        totalDrawCalls += drawCalls;
+        frames++;
+        drawCalls = 0;
+
+        lastFrameTextureBinds = textureBinds;
+        peakTextureBinds = std::max(peakTextureBinds, textureBinds);
+        totalTextureBinds += textureBinds;
+        textureBinds = 0;
+
+        uint64_t allocations = heapAllocations.load(std::memory_order_relaxed);
+        lastFrameAllocations = allocations - allocationsAtFrameStart;
+        allocationsAtFrameStart = allocations;
+        peakAllocations = std::max(peakAllocations, lastFrameAllocations);
+        if (lastFrameAllocations == 0) allocationFreeFrames++;
+    }
+
+    //SFML only rebinds when a draw uses a different texture (or none) from the draw before it
+    void useTexture(const sf::Texture* texture) {
+        if (texture != boundTexture) {
+            textureBinds++;
+            boundTexture = texture;
+        }
+    }
+
+    //rounds ending save scores and replays, those ticks are expected to allocate
+    void countTick(uint64_t allocations, bool roundOver) {
+        if (roundOver) return;
+        gameplayTicks++;
+        if (allocations > 0) allocatingTicks++;
+    }
+
+    void printStats(std::ostream& out) const {
+        out << "Render: " << (frames ? static_cast<double>(totalDrawCalls) / frames : 0.0)
+            << " draw calls per frame on average, peak " << peakDrawCalls << std::endl;
+        out << "Texture binds: " << (frames ? static_cast<double>(totalTextureBinds) / frames : 0.0)
+            << " per frame on average, peak " << peakTextureBinds << std::endl;
+        out << "Allocations: " << allocationFreeFrames << " of " << frames
+            << " frames allocated nothing, peak " << peakAllocations << " allocations in one frame" << std::endl;
+        out << "Gameplay allocations: " << allocatingTicks << " of " << gameplayTicks << " simulation ticks allocated" << std::endl;
+    }
+};
+
+//every draw goes through here so draw calls and texture binds per frame can be counted
+inline void drawCounted(sf::RenderTarget& target, const sf::Drawable& drawable,
+    const sf::RenderStates& states = sf::RenderStates::Default) {
+    RenderStats::instance().drawCalls++;
+    RenderStats::instance().useTexture(states.texture);
+    target.draw(drawable, states);
+}
+
+// A full-window background. The texture is already the window's size so it draws 1:1 with no
+// scaled sampling; when a resize re-bakes it the sprite is refitted on the next draw.
+class Background {
+private:
+    std::shared_ptr<const sf::Texture> texture;
+    sf::Sprite sprite;
+    sf::Vector2u fittedSize;
+
+    void fit() {
+        fittedSize = texture->getSize();
+        sprite.setTexture(*texture, true);
+        if (fittedSize.x > 0 && fittedSize.y > 0) {
+            // the view stays WINDOW_WIDTH x WINDOW_HEIGHT however big the window is, this undoes that stretch
+            sprite.setScale(static_cast<float>(WINDOW_WIDTH) / fittedSize.x, static_cast<float>(WINDOW_HEIGHT) / fittedSize.y);
+        }
+    }
+
+public:
+    void load(const std::string& path) {
+        texture = AssetCache::instance().getBackground(path);
+        fit();
+    }
+
+    void draw(sf::RenderTarget& target);
+};
+
+// Sprites, text and shapes carry their own texture rather than passing it in the states
+inline void drawCounted(sf::RenderTarget& target, const sf::Sprite& sprite) {
+    RenderStats::instance().drawCalls++;
+    RenderStats::instance().useTexture(sprite.getTexture());
+    target.draw(sprite);
+}
+
+inline void drawCounted(sf::RenderTarget& target, const sf::Text& text) {
+    RenderStats::instance().drawCalls++;
+    RenderStats::instance().useTexture(text.getFont() ? &text.getFont()->getTexture(text.getCharacterSize()) : nullptr);
+    target.draw(text);
+}
+
+inline void drawCounted(sf::RenderTarget& target, const sf::Shape& shape) {
+    RenderStats::instance().drawCalls++;
+    RenderStats::instance().useTexture(shape.getTexture());
+    target.draw(shape);
+}
+
+void Background::draw(sf::RenderTarget& target) {
+    if (texture->getSize() != fittedSize) fit();
+    drawCounted(target, sprite);
+}
+
+// Keyboard state built from the window's event stream. Presses are edges that stay pending
+// until something consumes them or the frame ends, so a tap shorter than a frame is never lost
+// and nothing has to sleep to debounce a key. Also measures how long presses take to reach
+// the simulation and the screen.
+class InputState {
+private:
+    std::array<bool, sf::Keyboard::KeyCount> held;
+    std::array<bool, sf::Keyboard::KeyCount> pressed; // since the end of the last frame
+    std::array<sf::Time, sf::Keyboard::KeyCount> pressedAt;
+    sf::Clock clock;
+
+    // Latency from the press being polled to the tick that used it, and to the frame that showed it
+    bool consumedThisFrame;
+    sf::Time consumedPressAt;
+    uint64_t measuredPresses;
+    sf::Time totalTickLatency;
+    sf::Time totalDisplayLatency;
+    sf::Time maxDisplayLatency;
+
+    InputState() : consumedThisFrame(false), measuredPresses(0) {
+        held.fill(false);
+        pressed.fill(false);
+    }
+
+    static bool valid(sf::Keyboard::Key key) { return key >= 0 && key < sf::Keyboard::KeyCount; }
+
+public:
+    InputState(const InputState&) = delete;
+    InputState& operator=(const InputState&) = delete;
+
+    static InputState& instance() {
+        static InputState input;
+        return input;
+    }
+
+    void handleEvent(const sf::Event& event) {
+        if (event.type == sf::Event::KeyPressed && valid(event.key.code)) {
+            if (!held[event.key.code] && !pressed[event.key.code]) {
+                pressed[event.key.code] = true;
+                pressedAt[event.key.code] = clock.getElapsedTime();
+            }
+            held[event.key.code] = true;
+        }
+        else if (event.type == sf::Event::KeyReleased && valid(event.key.code)) {
+            held[event.key.code] = false;
+        }
+        else if (event.type == sf::Event::LostFocus) {
+            held.fill(false); // the release would go to another window
+        }
+    }
+
+    bool isHeld(sf::Keyboard::Key key) const { return valid(key) && held[key]; }
+
+    //true once per press
+    bool consumePress(sf::Keyboard::Key key) {
+        if (!valid(key) || !pressed[key]) return false;
+        pressed[key] = false;
+        return true;
+    }
+
+    sf::Time now() const { return clock.getElapsedTime(); }
+    sf::Time pressTime(sf::Keyboard::Key key) const { return valid(key) ? pressedAt[key] : sf::Time::Zero; }
+
+    //a simulation tick just acted on a press polled at pressTime
+    void pressReachedTick(sf::Time pressTime) {
+        totalTickLatency += now() - pressTime;
+        if (!consumedThisFrame || pressTime < consumedPressAt) consumedPressAt = pressTime;
+        consumedThisFrame = true;
+        measuredPresses++;
+    }
+
+    //call right after window.display(), drops presses nobody asked for this frame
+    void endFrame() {
+        if (consumedThisFrame) {
+            sf::Time latency = now() - consumedPressAt;
+            totalDisplayLatency += latency;
+            maxDisplayLatency = std::max(maxDisplayLatency, latency);
+            consumedThisFrame = false;
+        }
+        pressed.fill(false);
+    }
+
+    void printStats(std::ostream& out) const {
+        double presses = measuredPresses ? static_cast<double>(measuredPresses) : 1.0;
+        out << "Input latency: " << measuredPresses << " presses, " << totalTickLatency.asSeconds() * 1000.0 / presses
+            << "ms to the simulation and " << totalDisplayLatency.asSeconds() * 1000.0 / presses
+            << "ms to the screen on average, worst " << maxDisplayLatency.asMilliseconds() << "ms" << std::endl;
+    }
+};
+
+// Collects quads into a single vertex array so a whole layer of sprites or shapes is one draw call
+class QuadBatch {
+private:
+    sf::VertexArray vertices;
+
+public:
+    QuadBatch() : vertices(sf::Quads) {}
+
+    void clear() { vertices.clear(); }
+    size_t getQuadCount() const { return vertices.getVertexCount() / 4; }
+
+    //textured quad of the given size centred on center, rotated like sf::Sprite::setRotation
+    void addSprite(const sf::Vector2f& center, const sf::Vector2f& size, float rotation, const sf::FloatRect& texRect) {
+        float radians = rotation * 3.14159265f / 180.f;
+        float c = std::cos(radians), s = std::sin(radians);
+        float hw = size.x / 2.f, hh = size.y / 2.f;
+
+        const sf::Vector2f corners[4] = { { -hw, -hh }, { hw, -hh }, { hw, hh }, { -hw, hh } };
+        const sf::Vector2f texCoords[4] = {
+            { texRect.left, texRect.top },
+            { texRect.left + texRect.width, texRect.top },
+            { texRect.left + texRect.width, texRect.top + texRect.height },
+            { texRect.left, texRect.top + texRect.height }
+        };
+        for (int i = 0; i < 4; ++i) {
+            sf::Vector2f p(center.x + corners[i].x * c - corners[i].y * s, center.y + corners[i].x * s + corners[i].y * c);
+            vertices.append(sf::Vertex(p, texCoords[i]));
+        }
+    }
+
+    //solid axis-aligned rectangle
+    void addRect(float left, float top, float width, float height, const sf::Color& color) {
+        vertices.append(sf::Vertex(sf::Vector2f(left, top), color));
+        vertices.append(sf::Vertex(sf::Vector2f(left + width, top), color));
+        vertices.append(sf::Vertex(sf::Vector2f(left + width, top + height), color));
+        vertices.append(sf::Vertex(sf::Vector2f(left, top + height), color));
+    }
+
+    void draw(sf::RenderTarget& target, const sf::Texture* texture = nullptr) const {
+        if (vertices.getVertexCount() == 0) return;
+        sf::RenderStates states;
+        states.texture = texture;
+        drawCounted(target, vertices, states);
+    }
+};
+
+// In-game HUD. The sf::Text objects live as long as the game and a string is only
+// re-formatted and re-laid out when the value bound to it changes
+class Hud {
+private:
+    sf::Text scoreText;
+    sf::Text highScoreText;
+    sf::Text livesText;
+    sf::Text muteText;
+    sf::Text gameOverText;
+    sf::Text pausedText;
+    int shownScore;
+    int shownHighScore;
+    int shownLives;
+    int shownMuted; // -1 until the first update, then 0 or 1
+
+    static void setupText(sf::Text& text, const sf::Font& font, unsigned size, const sf::Color& color, float x, float y) {
+        text.setFont(font);
+        text.setCharacterSize(size);
+        text.setFillColor(color);
+        text.setPosition(x, y);
+    }
+
+public:
+    Hud() : shownScore(-1), shownHighScore(-1), shownLives(-1), shownMuted(-1) {}
+
+    void setup(const sf::Font& font, const sf::Color& color) {
+        setupText(scoreText, font, 20, color, 10, 10);
+        setupText(highScoreText, font, 20, color, 10, 40);
+        setupText(livesText, font, 20, color, 10, 70);
+
+        // mute text is anchored using the width of the bare label, like it always was
+        muteText.setFont(font);
+        muteText.setString(MUTE_TEXT);
+        muteText.setCharacterSize(20);
+        muteText.setFillColor(sf::Color::White);
+        muteText.setPosition(WINDOW_WIDTH - muteText.getLocalBounds().width - 10, 10);
+
+        gameOverText.setFont(font);
+        gameOverText.setString("GAME OVER\nPress R to Restart\nPress M for Menu");
+        gameOverText.setCharacterSize(30);
+        gameOverText.setFillColor(sf::Color::Red);
+        gameOverText.setPosition(
+            static_cast<float>(WINDOW_WIDTH) / 2.0f - gameOverText.getLocalBounds().width / 2.0f,
+            static_cast<float>(WINDOW_HEIGHT) / 2.0f - 50.0f
+        );
+
+        pausedText.setFont(font);
+        pausedText.setString("PAUSED\nPress P to Resume\nPress M for Menu");
+        pausedText.setCharacterSize(30);
+        pausedText.setFillColor(color);
+        pausedText.setPosition(
+            static_cast<float>(WINDOW_WIDTH) / 2.0f - pausedText.getLocalBounds().width / 2.0f,
+            static_cast<float>(WINDOW_HEIGHT) / 2.0f - 50.0f
+        );
+    }
+
+    //re-lays out only the strings whose value changed since the last call
+    void update(int score, int highScore, int lives, bool musicMuted) {
+        if (score != shownScore) {
+            shownScore = score;
+            scoreText.setString("Score: " + std::to_string(score));
+        }
+        if (highScore != shownHighScore) {
+            shownHighScore = highScore;
+            highScoreText.setString("High Score: " + std::to_string(highScore));
+        }
+        if (lives != shownLives) {
+            shownLives = lives;
+            livesText.setString("Lives: " + std::to_string(lives));
+        }
+        if (static_cast<int>(musicMuted) != shownMuted) {
+            shownMuted = musicMuted;
+            muteText.setString(std::string(MUTE_TEXT) + (musicMuted ? " (OFF)" : " (ON)"));
+        }
+    }
+
+    void draw(sf::RenderTarget& target, bool gameOver, bool paused) const {
+        drawCounted(target, muteText);
+        drawCounted(target, scoreText);
+        drawCounted(target, highScoreText);
+        drawCounted(target, livesText);
+        if (gameOver) {
+            drawCounted(target, gameOverText);
+        }
+        else if (paused) {
+            drawCounted(target, pausedText);
+        }
+    }
+};
+
+// Screens and games the main loop switches between
+enum SceneId { SCENE_MENU, SCENE_SNAKE, SCENE_FLAPPY, SCENE_INSTRUCTIONS, SCENE_HIGH_SCORES, SCENE_COUNT };
+
+// Something the main loop shows: a menu screen or a game
+class Scene {
+protected:
+    bool closeRequested; // set by the scene to go back to whatever it covered
+
+public:
+    Scene() : closeRequested(false) {}
+    virtual ~Scene() {}
+
+    virtual void handleInput() = 0; // once per frame while on top
+    virtual void update() {} // one simulation tick, only games have any
+    // alpha is how far (0..1) the render time is between the previous tick and the current one
+    virtual void draw(float alpha) = 0;
+    virtual void resume() {} // back on top of the stack
+    virtual void suspend() {} // covered by another scene or popped, it stays built for next time
+
+    bool takeCloseRequest() {
+        bool requested = closeRequested;
+        closeRequested = false;
+        return requested;
+    }
+};
+
+// Stack of scenes with the running one on top. Every scene is built once, on first use or ahead of
+// time with prepare(), and kept, so switching back to one is a push or a pop with no loading.
+class SceneManager {
+private:
+    std::function<std::unique_ptr<Scene>(SceneId)> factory;
+    std::array<std::unique_ptr<Scene>, SCENE_COUNT> scenes;
+    std::vector<SceneId> stack;
+
+    // Switch latency, from the switch being asked for to the first frame of the new scene on screen
+    sf::Clock switchClock;
+    bool switchPending;
+    bool switchBuilt; // the pending switch had to construct its scene
+    int switches;
+    int coldSwitches;
+    sf::Time totalSwitchTime;
+    sf::Time maxSwitchTime;
+    int built;
+    sf::Time buildTime;
+
+public:
+    explicit SceneManager(std::function<std::unique_ptr<Scene>(SceneId)> build)
+        : factory(std::move(build)), switchPending(false), switchBuilt(false), switches(0), coldSwitches(0), built(0) {}
+
+    //the scene, built now if it hasn't been yet
+    Scene& get(SceneId id) {
+        if (!scenes[id]) {
+            sf::Clock clock;
+            scenes[id] = factory(id);
+            buildTime += clock.getElapsedTime();
+            built++;
+            if (switchPending) switchBuilt = true;
+        }
+        return *scenes[id];
+    }
+
+    bool isBuilt(SceneId id) const { return scenes[id] != nullptr; }
+
+    //builds a scene ahead of time so switching to it later is instant
+    void prepare(SceneId id) { get(id); }
+
+    //starts timing a switch that has to wait for something (e.g. assets) before it can push
+    void beginSwitch() {
+        if (switchPending) return;
+        switchClock.restart();
+        switchPending = true;
+        switchBuilt = false;
+    }
+
+    void push(SceneId id) {
+        beginSwitch();
+        if (!stack.empty()) top().suspend();
+        Scene& scene = get(id);
+        stack.push_back(id);
+        scene.resume();
+    }
+
+    void pop() {
+        if (stack.empty()) return;
+        beginSwitch();
+        top().suspend();
+        stack.pop_back();
+        if (!stack.empty()) top().resume();
+    }
+
+    bool empty() const { return stack.empty(); }
+    SceneId topId() const { return stack.back(); }
+    Scene& top() { return *scenes[stack.back()]; }
+
+    //call after the frame is displayed, closes the timing of a switch made this frame
+    void frameShown() {
+        if (!switchPending || stack.empty()) return;
+        sf::Time elapsed = switchClock.getElapsedTime();
+        switchPending = false;
+        switches++;
+        coldSwitches += switchBuilt;
+        totalSwitchTime += elapsed;
+        maxSwitchTime = std::max(maxSwitchTime, elapsed);
+    }
+
+    void printStats(std::ostream& out) const {
+        out << "Scenes: " << built << " built in " << buildTime.asSeconds() * 1000.f << "ms total, " << switches << " switches ("
+            << coldSwitches << " had to build their scene), "
+            << (switches ? totalSwitchTime.asSeconds() * 1000.f / switches : 0.f) << "ms average and "
+            << maxSwitchTime.asSeconds() * 1000.f << "ms worst from the switch to its first frame on screen" << std::endl;
+    }
+};
 
 // Base Game Class
-class Game {
+class Game : public Scene {
     //Implementing encapsulation
 protected:
     //declaring variables
-    sf::RenderWindow& window;
-    sf::Font font;
+    sf::RenderTarget& window; // the game window, or an offscreen texture when benchmarking
+    std::shared_ptr<const sf::Font> font;
     bool gameOver;
+    bool paused; // the round is on hold, no ticks run until it's resumed
     bool musicMuted;
     int score;
     int highScore;
     int lives;
-    sf::SoundBuffer gameOverBuffer;
+    uint8_t inputBits; // InputBits for keys held down, sent every tick
+    uint8_t pendingPresses; // InputBits for keys pressed since the last tick, sent to the next tick only
+    sf::Time pendingPressTime; // when the oldest pending press was polled
+    SimRandom seedSource; // seeded once per game instance, hands out the seed for each round
+    GameKind kind;
+    int ticksPerSecond;
+    std::string recordDir; // finished rounds are also saved here as replay files when set
+    Replay recording; // every round is recorded in memory, its hash goes on the leaderboard
+    std::shared_ptr<const Replay> playback; // when set the game plays this replay instead of the keyboard
+    std::unique_ptr<ReplayCursor> playbackCursor;
+    bool unranked; // a bot played some of this round, so it stays off the leaderboard
+    std::shared_ptr<const sf::SoundBuffer> gameOverBuffer;
     sf::Sound gameOverSound;
-    sf::SoundBuffer pointBuffer;
+    std::shared_ptr<const sf::SoundBuffer> pointBuffer;
     sf::Sound pointSound;
-    std::string highScoreFile;
-    sf::Texture backgroundTexture;
-    sf::Sprite background;
-    sf::Text muteText;
+    Background background;
+    Hud hud;
+
+    //seed for the round about to start, a replay always restarts with its own seed
+    uint64_t beginRound() {
+        uint64_t roundSeed = playback ? playback->seed : seedSource.next64();
+        if (playback) {
+            playbackCursor = std::make_unique<ReplayCursor>(*playback);
+        }
+        else {
+            playbackCursor.reset(); // the game is kept between plays, a replay it showed before is done
+            recording.start(kind, ticksPerSecond, roundSeed);
+        }
+        // keys pressed during the last round, or while a replay played, don't carry into this one
+        inputBits = INPUT_NONE;
+        pendingPresses = INPUT_NONE;
+        unranked = false;
+        paused = false;
+        return roundSeed;
+    }
 
-public:
-    Game(sf::RenderWindow& win, const std::string& hsFile, const std::string& bgPath)
-        : window(win), gameOver(false), musicMuted(false),
-        score(0), highScore(0), lives(3), highScoreFile(hsFile) { 
-        if (!font.loadFromFile("D:/happy/mycode/Assets/Font/Arcade_R.ttf")) {
-            std::cerr << "Failed to load font" << std::endl;
+    //the input for the next tick, either from the replay or from the keyboard (and then recorded)
+    uint8_t tickInput() {
+        if (gameOver) return INPUT_NONE;
+        if (playbackCursor) return playbackCursor->next();
+
+        uint8_t bits = inputBits | pendingPresses;
+        if (pendingPresses) {
+            InputState::instance().pressReachedTick(pendingPressTime);
+            pendingPresses = INPUT_NONE;
         }
+        recording.record(bits);
+        return bits;
+    }
 
-        // Load background
-        if (!backgroundTexture.loadFromFile(bgPath)) { //error message displayed  in case background doesnt work
-            std::cerr << "Failed to load background texture" << std::endl;
+    //the same, with the input coming from a bot instead of the keyboard
+    uint8_t tickInput(uint8_t botBits) {
+        if (gameOver) return INPUT_NONE;
+        if (playbackCursor) return playbackCursor->next();
+
+        unranked = true;
+        recording.record(botBits);
+        return botBits;
+    }
+
+    //queues a press of key for the next tick
+    void queuePress(sf::Keyboard::Key key, uint8_t bit) {
+        InputState& input = InputState::instance();
+        if (!input.consumePress(key)) return;
+        if (playback) return; // a replay plays its own input, the press is dropped
+        if (!pendingPresses || input.pressTime(key) < pendingPressTime) pendingPressTime = input.pressTime(key);
+        pendingPresses |= bit;
+    }
+
+    void saveRecording() {
+        std::ostringstream name;
+        name << gameName(kind) << "-" << std::hex << std::setw(16) << std::setfill('0') << recording.seed << ".rpl";
+        std::string path = (std::filesystem::path(recordDir) / name.str()).string();
+
+        if (!recording.save(path)) {
+            std::cerr << "Failed to save replay: " << path << std::endl;
         }
-        background.setTexture(backgroundTexture);
-        float scaleX = static_cast<float>(WINDOW_WIDTH) / backgroundTexture.getSize().x;
-        float scaleY = static_cast<float>(WINDOW_HEIGHT) / backgroundTexture.getSize().y;
-        background.setScale(scaleX, scaleY);
+    }
+
+    //draws the HUD on top of the scene, subclasses call this last
+    void drawHud() {
+        hud.update(score, highScore, lives, musicMuted);
+        hud.draw(window, gameOver, paused);
+    }
+
+public:
+    Game(sf::RenderTarget& win, const std::string& bgPath, const sf::Color& hudColor,
+        GameKind gameKind, uint64_t seed, int tickRate)
+        : window(win), gameOver(false), paused(false), musicMuted(false),
+        score(0), highScore(0), lives(START_LIVES), inputBits(INPUT_NONE), pendingPresses(INPUT_NONE), seedSource(seed),
+        kind(gameKind), ticksPerSecond(tickRate), unranked(false) { 
+        font = AssetCache::instance().getFont(ARCADE_FONT);
+
+        // Load background (shared through the asset cache)
+        background.load(bgPath);
 
         loadSounds();
         loadHighScore();
 
-        // Setup mute text
-        muteText.setFont(font);
-        muteText.setString(MUTE_TEXT);
-        muteText.setCharacterSize(20);
-        muteText.setFillColor(sf::Color::White);
-        muteText.setPosition(WINDOW_WIDTH - muteText.getLocalBounds().width - 10, 10);
+        hud.setup(*font, hudColor);
     }
 
     virtual ~Game() {} //virtual destructor to ensure objects are destroyed in correct order
 
-    virtual void handleInput() {
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::T)) {
+    //called once per frame before the frame's ticks
+    void handleInput() override {
+        InputState& input = InputState::instance();
+        if (input.consumePress(sf::Keyboard::T)) {
             musicMuted = !musicMuted;
-            sf::sleep(sf::milliseconds(200));
+        }
+        if (input.consumePress(sf::Keyboard::P) && !gameOver) {
+            paused = !paused;
         }
     }
 
-    virtual void update() = 0;
-    virtual void draw() {
-        window.draw(background);
-        muteText.setString(std::string(MUTE_TEXT) + (musicMuted ? " (OFF)" : " (ON)"));
-        window.draw(muteText);
+    void update() override = 0; // advances the game by exactly one simulation tick
+    void draw(float) override {
+        background.draw(window);
     };
     virtual void reset() = 0; //pure virtual function to ensure each class overrides this function
 
+    //a round left for the menu comes back on hold, so the player isn't dropped straight into it
+    void suspend() override {
+        if (!gameOver) paused = true;
+    }
+
     //function to handle audio files in game
     void loadSounds() {
-        if (!gameOverBuffer.loadFromFile(GAME_OVER_SOUND)) {
-            std::cerr << "Failed to load game over sound" << std::endl;
-        }
-        gameOverSound.setBuffer(gameOverBuffer);
+        gameOverBuffer = AssetCache::instance().getSoundBuffer(GAME_OVER_SOUND);
+        gameOverSound.setBuffer(*gameOverBuffer);
+
+        pointBuffer = AssetCache::instance().getSoundBuffer(POINT_SOUND);
+        pointSound.setBuffer(*pointBuffer);
+    }
+
+    //saves every finished round into dir, takes effect from the next round
+    void recordTo(const std::string& dir) {
+        std::error_code error;
+        std::filesystem::create_directories(dir, error);
+        recordDir = dir;
+    }
+
+    //plays the replay back instead of reading the keyboard, from the start of the next round
+    void playBack(std::shared_ptr<const Replay> replay) {
+        playback = std::move(replay);
+    }
+
+    bool isPlayingBack() const { return playback != nullptr; }
 
-        if (!pointBuffer.loadFromFile(POINT_SOUND)) {
-            std::cerr << "Failed to load point sound" << std::endl;
+    //plays the sounds for whatever the simulation reported this tick, call after syncing the score
+    void applyEvents(uint8_t events) {
+        if ((events & EVENT_POINT) && !musicMuted) pointSound.play();
+        if (events & EVENT_GAME_OVER) {
+            if (!musicMuted) gameOverSound.play();
+            if (!playback) {
+                recording.finish(score);
+                saveHighScore();
+                if (!recordDir.empty() && !unranked) saveRecording(); // bot rounds, e.g. attract mode demos, aren't kept
+            }
         }
-        pointSound.setBuffer(pointBuffer);
     }
 
-    //function to display highscore
+    //function to display highscore, served from the in-memory leaderboard
     void loadHighScore() {
-        std::ifstream file(highScoreFile);
-        if (file.is_open()) {
-            file >> highScore;
-            file.close();
-        }
+        highScore = Leaderboards::instance().get(kind).best();
     }
 
-    //function to keep updating high score
+    //puts the finished round on the leaderboard, tagged with its replay hash
     void saveHighScore() {
-        if (score > highScore) {
-            highScore = score;
-            std::ofstream file(highScoreFile);
-            if (file.is_open()) {
-                file << highScore;
-                file.close();
-            }
+        if (score <= 0 || unranked) return;
+        Leaderboard& board = Leaderboards::instance().get(kind);
+        if (!board.record({ Leaderboards::instance().getPlayerName(), score, static_cast<int64_t>(std::time(nullptr)), recording.hash() })) {
+            std::cerr << "Failed to save score" << std::endl;
         }
+        highScore = board.best();
     }
 
     bool isGameOver() const { return gameOver; }
+    bool isPaused() const { return paused; }
     bool isMusicMuted() const { return musicMuted; }
     int getScore() const { return score; }
     int getHighScore() const { return highScore; }
 };
 
-// Snake Game
+// Snake Game, a thin renderer on top of SnakeSim
 class SnakeGame : public Game {
 private:
-    struct SnakeSegment {
-        sf::Sprite sprite;
-        sf::Vector2f position;
-        float rotation;
-    };
-
-    std::vector<SnakeSegment> snake;
-    sf::Vector2f direction;
+    SnakeSim sim;
+    QuadBatch bodyBatch; // every segment in one draw call
+    uint32_t batchedBodyVersion; // sim.bodyVersion the batch was built from
     sf::Sprite food;
-    sf::Texture bodyTexture;
-    sf::Texture foodTexture;
-    float gridSize;
-    sf::Clock moveClock;
-    float moveDelay;
+    std::shared_ptr<const SpriteAtlas> atlas; // body and food come out of the same texture
+    sf::IntRect bodyRect;
+    SnakeAutopilot autopilot;
+    bool autopilotOn;
+    sf::Text autopilotText;
+    uint64_t shownPlans; // autopilot plan count autopilotText was last written at
+
+    //copies the simulation state the base class draws and reports
+    void syncState() {
+        score = sim.score;
+        lives = sim.lives;
+        gameOver = sim.gameOver;
+    }
+
+    static sf::Vector2f cellCenter(int x, int y) {
+        return sf::Vector2f(
+            static_cast<float>(x * SNAKE_GRID_SIZE) + SNAKE_GRID_SIZE / 2.0f,
+            static_cast<float>(y * SNAKE_GRID_SIZE) + SNAKE_GRID_SIZE / 2.0f
+        );
+    }
 
 public:
-    SnakeGame(sf::RenderWindow& win) : Game(win, SNAKE_HIGHSCORE_FILE, SNAKE_BACKGROUND), gridSize(32.f), moveDelay(0.15f) {
+    SnakeGame(sf::RenderTarget& win, uint64_t seed, int tickRate = SIM_TICKS_PER_SECOND)
+        : Game(win, SNAKE_BACKGROUND, sf::Color::Black, GAME_SNAKE, seed, tickRate),
+        sim(0, tickRate), batchedBodyVersion(0), autopilotOn(false), shownPlans(UINT64_MAX) {
         // Load textures
-        if (!bodyTexture.loadFromFile(SNAKE_BODY_TEXTURE)) {
-            std::cerr << "Failed to load snake body texture" << std::endl;
-        }
-        if (!foodTexture.loadFromFile(SNAKE_FOOD_TEXTURE)) {
-            std::cerr << "Failed to load food texture" << std::endl;
-        }
+        atlas = AssetCache::instance().getAtlas();
+        bodyRect = atlas->rect(SNAKE_BODY_TEXTURE);
+        sf::IntRect foodRect = atlas->rect(SNAKE_FOOD_TEXTURE);
+
+        food.setTexture(atlas->texture);
+        food.setTextureRect(foodRect);
+        food.setOrigin(foodRect.width / 2.0f, foodRect.height / 2.0f);
+        food.setScale(0.5f, 0.5f); // Scale down the food
+
+        autopilotText.setFont(*font);
+        autopilotText.setCharacterSize(14);
+        autopilotText.setFillColor(sf::Color::Yellow);
+        autopilotText.setPosition(10, WINDOW_HEIGHT - 30);
 
         reset();
     }
 
     void reset() override { //overriding reset function
-        snake.clear();
-        gameOver = false;  
-        score = 0;  //giving user an initial score of 0
-        lives = 3; //giving player 3 lives
-
-        // Initial snake
-        for (int i = 0; i < 3; ++i) {
-            SnakeSegment segment;
-            segment.sprite.setTexture(bodyTexture);
-            segment.sprite.setOrigin(bodyTexture.getSize().x / 2.0f, bodyTexture.getSize().y / 2.0f);
-            segment.sprite.setScale(0.5f, 0.5f); // Scale down the sprite
-            segment.position = sf::Vector2f(
-                static_cast<float>(WINDOW_WIDTH) / 2.0f,
-                static_cast<float>(WINDOW_HEIGHT) / 2.0f + i * gridSize
-            );
-            segment.rotation = 0.f;
-            segment.sprite.setPosition(segment.position);
-            segment.sprite.setRotation(segment.rotation);
-            snake.push_back(segment);
-        }
-
-        direction = sf::Vector2f(0, -1); // Up
-        spawnFood();
-        moveClock.restart();
-    }
-
-    void spawnFood() { //function to generate food 
-        food.setTexture(foodTexture);
-        food.setOrigin(foodTexture.getSize().x / 2.0f, foodTexture.getSize().y / 2.0f);
-        food.setScale(0.5f, 0.5f); // Scale down the food
+        sim.reset(beginRound());
+        autopilot.clear();
+        syncState();
+    }
 
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> xDist(0, static_cast<int>((WINDOW_WIDTH / gridSize) - 1));
-        std::uniform_int_distribution<> yDist(0, static_cast<int>((WINDOW_HEIGHT / gridSize) - 1));
+    //lets the autopilot steer (A toggles it in game), its rounds aren't ranked
+    void setAutopilot(bool on) {
+        autopilotOn = on;
+        shownPlans = UINT64_MAX;
+    }
 
-        //function to randomly set position where food spawns
-        food.setPosition(
-            static_cast<float>(xDist(gen)) * gridSize + gridSize / 2,
-            static_cast<float>(yDist(gen)) * gridSize + gridSize / 2
-        );
+    bool isAutopilot() const { return autopilotOn; }
+    const AutopilotStats& getAutopilotStats() const { return autopilot.getStats(); }
+
+    void rebuildBodyBatch() {
+        // the body texture is drawn at half size, filling one grid cell
+        sf::Vector2f size(bodyRect.width * 0.5f, bodyRect.height * 0.5f);
+        sf::FloatRect texRect(bodyRect);
+
+        bodyBatch.clear();
+        for (int i = 0; i < sim.length; ++i) {
+            const SnakeCell& segment = sim.segment(i);
+            bodyBatch.addSprite(cellCenter(segment.x, segment.y), size, segment.direction * 90.f, texRect);
+        }
+        batchedBodyVersion = sim.bodyVersion;
     }
+
     //function to take user inpiut
     void handleInput() override {
         Game::handleInput(); // Handle common input first
 
-        if (gameOver) return;
-
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Up) && direction.y == 0)
-            direction = sf::Vector2f(0, -1);
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Down) && direction.y == 0)
-            direction = sf::Vector2f(0, 1);
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left) && direction.x == 0)
-            direction = sf::Vector2f(-1, 0);
-        else if (sf::Keyboard::isKeyPressed(sf::Keyboard::Right) && direction.x == 0)
-            direction = sf::Vector2f(1, 0);
+        inputBits = INPUT_NONE;
+        if (gameOver || paused) return;
+        if (InputState::instance().consumePress(sf::Keyboard::A)) setAutopilot(!autopilotOn);
+        if (autopilotOn) return;
+
+        // a quick tap still turns the snake even if it was released before the next tick
+        const InputState& input = InputState::instance();
+        const std::pair<sf::Keyboard::Key, uint8_t> arrows[] = {
+            { sf::Keyboard::Up, INPUT_UP }, { sf::Keyboard::Down, INPUT_DOWN },
+            { sf::Keyboard::Left, INPUT_LEFT }, { sf::Keyboard::Right, INPUT_RIGHT } };
+        for (const auto& arrow : arrows) {
+            if (input.isHeld(arrow.first)) inputBits |= arrow.second;
+            queuePress(arrow.first, arrow.second);
+        }
     }
+
     //function to keep track if game is in session
     void update() override {
-        if (gameOver) return; 
-
-        if (moveClock.getElapsedTime().asSeconds() > moveDelay) {
-            moveClock.restart();
-
-            // Move snake
-            for (int i = static_cast<int>(snake.size()) - 1; i > 0; --i) {
-                snake[i].position = snake[i - 1].position;
-                snake[i].rotation = snake[i - 1].rotation;
-                snake[i].sprite.setPosition(snake[i].position);
-                snake[i].sprite.setRotation(snake[i].rotation);
-            }
-
-            // Update head position and rotation
-            snake[0].position += direction * gridSize;
-
-            // Set rotation based on direction
-            if (direction.x == 1) snake[0].rotation = 0; // Right
-            else if (direction.x == -1) snake[0].rotation = 180; // Left
-            else if (direction.y == -1) snake[0].rotation = 270; // Up
-            else if (direction.y == 1) snake[0].rotation = 90; // Down
-
-            snake[0].sprite.setPosition(snake[0].position);
-            snake[0].sprite.setRotation(snake[0].rotation);
-
-            // Check collisions with walls
-            if (snake[0].position.x < gridSize / 2 || snake[0].position.x >= WINDOW_WIDTH - gridSize / 2 ||
-                snake[0].position.y < gridSize / 2 || snake[0].position.y >= WINDOW_HEIGHT - gridSize / 2) {
-                lives--;
-                if (lives <= 0) {
-                    gameOver = true;
-                    if (!musicMuted) gameOverSound.play();
-                    saveHighScore();
-                }
-                else {
-                    // Reset position but keep score
-                    snake[0].position = sf::Vector2f(
-                        static_cast<float>(WINDOW_WIDTH) / 2.0f,
-                        static_cast<float>(WINDOW_HEIGHT) / 2.0f
-                    );
-                    direction = sf::Vector2f(0, -1);
-                }
-            }
-
-            // Check collision with self
-            for (size_t i = 1; i < snake.size(); ++i) {
-                if (snake[0].position == snake[i].position) {
-                    lives--;
-                    if (lives <= 0) {
-                        gameOver = true;
-                        if (!musicMuted) gameOverSound.play();
-                        saveHighScore();
-                    }
-                    else {
-                        // Reset position but keep score
-                        snake[0].position = sf::Vector2f(
-                            static_cast<float>(WINDOW_WIDTH) / 2.0f,
-                            static_cast<float>(WINDOW_HEIGHT) / 2.0f
-                        );
-                        direction = sf::Vector2f(0, -1);
-                    }
-                    break;
-                }
-            }
-
-            // Check collision with food
-            if (snake[0].sprite.getGlobalBounds().intersects(food.getGlobalBounds())) {
-                if (!musicMuted) pointSound.play();
-                score += 10;
-
-                // Add new segment
-                SnakeSegment newSegment;
-                newSegment.sprite.setTexture(bodyTexture);
-                newSegment.sprite.setOrigin(bodyTexture.getSize().x / 2.0f, bodyTexture.getSize().y / 2.0f);
-                newSegment.sprite.setScale(0.5f, 0.5f);
-                newSegment.position = snake.back().position;
-                newSegment.rotation = snake.back().rotation;
-                newSegment.sprite.setPosition(newSegment.position);
-                newSegment.sprite.setRotation(newSegment.rotation);
-                snake.push_back(newSegment);
-
-                spawnFood();
-            }
-        }
+        uint8_t events = sim.step(autopilotOn ? tickInput(autopilot.next(sim)) : tickInput());
+        syncState();
+        applyEvents(events);
     }
 
-    void draw() override {
-        Game::draw(); // Draw background first
+    // The snake moves cell by cell so it is drawn at its current tick without interpolation
+    void draw(float alpha) override {
+        Game::draw(alpha); // Draw background first
 
         // Draw food
-        window.draw(food);
+        food.setPosition(cellCenter(sim.foodX, sim.foodY));
+        drawCounted(window, food);
 
-        // Draw snake
-        for (auto& segment : snake) {
-            window.draw(segment.sprite);
+        // Draw snake, the batch is only rebuilt on the ticks the body actually moved
+        if (sim.bodyVersion != batchedBodyVersion) {
+            rebuildBodyBatch();
+        }
+        bodyBatch.draw(window, &atlas->texture);
+
+        // Planning cost, the text only changes when the autopilot plans again
+        if (autopilotOn) {
+            const AutopilotStats& stats = autopilot.getStats();
+            if (stats.plans != shownPlans) {
+                shownPlans = stats.plans;
+                std::ostringstream text;
+                text << std::fixed << std::setprecision(1) << "AUTOPILOT (A)  plan " << stats.averageMicros()
+                    << "us/tick avg, " << stats.maxMicros() << "us max";
+                autopilotText.setString(text.str());
+            }
+            drawCounted(window, autopilotText);
         }
 
         // Draw UI
-        sf::Text scoreText;
-        scoreText.setFont(font);
-        scoreText.setString("Score: " + std::to_string(score));
-        scoreText.setCharacterSize(20);
-        scoreText.setFillColor(sf::Color::Black);
-        scoreText.setPosition(10, 10);
-        window.draw(scoreText);
-
-        sf::Text highScoreText;
-        highScoreText.setFont(font);
-        highScoreText.setString("High Score: " + std::to_string(highScore));
-        highScoreText.setCharacterSize(20);
-        highScoreText.setFillColor(sf::Color::Black);
-        highScoreText.setPosition(10, 40);
-        window.draw(highScoreText);
-
-        sf::Text livesText;
-        livesText.setFont(font);
-        livesText.setString("Lives: " + std::to_string(lives));
-        livesText.setCharacterSize(20);
-        livesText.setFillColor(sf::Color::Black);
-        livesText.setPosition(10, 70);
-        window.draw(livesText);
-
-        if (gameOver) {
-            sf::Text gameOverText;
-            gameOverText.setFont(font);
-            gameOverText.setString("GAME OVER\nPress R to Restart\nPress M for Menu");
-            gameOverText.setCharacterSize(30);
-            gameOverText.setFillColor(sf::Color::Red);
-            gameOverText.setPosition(
-                static_cast<float>(WINDOW_WIDTH) / 2.0f - gameOverText.getLocalBounds().width / 2.0f,
-                static_cast<float>(WINDOW_HEIGHT) / 2.0f - 50.0f
-            );
-            window.draw(gameOverText);
-        }
+        drawHud();
     }
 };
 
-// Flappy Bird Game
+// Flappy Bird Game, a thin renderer on top of FlappySim
 class FlappyBirdGame : public Game {
 private:
+    FlappySim sim;
+    float prevBirdY; // bird state one tick ago, for interpolated rendering
+    float prevBirdRotation;
     sf::Sprite bird;
-    sf::Texture birdTexture;
-    float birdVelocity;
-    float gravity;
-    std::vector<sf::RectangleShape> pipes;
-    float pipeSpeed;
-    float pipeGap;
-    float pipeSpawnTimer;
-    float pipeSpawnDelay;
-    bool passedPipe;
+    std::shared_ptr<const SpriteAtlas> atlas;
+    QuadBatch pipeBatch; // every pipe in one draw call
 
-public: // Rendering Flappy Bird 
-    FlappyBirdGame(sf::RenderWindow& win) : Game(win, FLAPPY_HIGHSCORE_FILE, FLAPPY_BACKGROUND),
-        birdVelocity(0.f), gravity(0.5f), pipeSpeed(3.f),
-        pipeGap(200.f), pipeSpawnTimer(0.f), pipeSpawnDelay(2.f), passedPipe(false) {
-        reset();
+    void syncState() {
+        score = sim.score;
+        lives = sim.lives;
+        gameOver = sim.gameOver;
     }
 
-    void reset() override { // Giving User inital score of 0 and 3 Lives at the start
-        gameOver = false;
-        score = 0;
-        lives = 3;
-
-        // Load bird texture
-        if (!birdTexture.loadFromFile(BIRD_TEXTURE)) {
-            std::cerr << "Failed to load bird texture" << std::endl;
-        }
-
-        bird.setTexture(birdTexture);
+public: // Rendering Flappy Bird 
+    FlappyBirdGame(sf::RenderTarget& win, uint64_t seed, int tickRate = SIM_TICKS_PER_SECOND)
+        : Game(win, FLAPPY_BACKGROUND, sf::Color::White, GAME_FLAPPY, seed, tickRate),
+        sim(0, tickRate) {
+        // Load bird texture once, restarts reuse it
+        atlas = AssetCache::instance().getAtlas();
+        sf::IntRect birdRect = atlas->rect(BIRD_TEXTURE);
+        bird.setTexture(atlas->texture);
+        bird.setTextureRect(birdRect);
         bird.setScale(0.1f, 0.1f); // Adjust scale as needed
-        bird.setOrigin(birdTexture.getSize().x / 2.0f, birdTexture.getSize().y / 2.0f);
-        bird.setPosition(
-            static_cast<float>(WINDOW_WIDTH) / 4.0f,
-            static_cast<float>(WINDOW_HEIGHT) / 2.0f
-        );
-        birdVelocity = 0.f;
-        bird.setRotation(0);
+        bird.setOrigin(birdRect.width / 2.0f, birdRect.height / 2.0f);
 
-        pipes.clear();
-        pipeSpawnTimer = 0.f;
-        passedPipe = false;
+        reset();
     }
 
-    void spawnPipe() {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> heightDist(100, WINDOW_HEIGHT - 300);
-
-        float height = static_cast<float>(heightDist(gen));
-
-        // Upper pipe
-        sf::RectangleShape upperPipe;
-        upperPipe.setSize(sf::Vector2f(80, height));
-        upperPipe.setFillColor(sf::Color::Green);
-        upperPipe.setPosition(static_cast<float>(WINDOW_WIDTH), 0.0f);
-        pipes.push_back(upperPipe);
-
-        // Lower pipe
-        sf::RectangleShape lowerPipe;
-        lowerPipe.setSize(sf::Vector2f(80, static_cast<float>(WINDOW_HEIGHT) - height - pipeGap));
-        lowerPipe.setFillColor(sf::Color::Green);
-        lowerPipe.setPosition(static_cast<float>(WINDOW_WIDTH), height + pipeGap);
-        pipes.push_back(lowerPipe);
+    void reset() override { // Giving User inital score of 0 and 3 Lives at the start
+        sim.reset(beginRound());
+        prevBirdY = sim.birdY;
+        prevBirdRotation = sim.birdRotation;
+        syncState();
     }
 
     void handleInput() override {
         Game::handleInput();
 
+        inputBits = INPUT_NONE;
         //function to keep track if game is in session
-        if (gameOver) return;
+        if (gameOver || paused) return;
 
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space)) {
-            birdVelocity = -10.f;
-            bird.setRotation(-30); // Tilt up when jumping
-        }
+        // one flap per press, holding space doesn't keep flapping
+        queuePress(sf::Keyboard::Space, INPUT_FLAP);
     }
 
     void update() override {
-        if (gameOver) return;
-
-        // Bird physics
-        birdVelocity += gravity;
-        bird.move(0, birdVelocity);
-
-        // Gradually rotate bird downward
-        if (bird.getRotation() < 90 && birdVelocity > 0) {
-            bird.rotate(2.0f);
+        prevBirdY = sim.birdY;
+        prevBirdRotation = sim.birdRotation;
+
+        uint8_t events = sim.step(tickInput());
+        if (events & EVENT_LIFE_LOST) {
+            // the bird was put back at the start, don't blend across the jump
+            prevBirdY = sim.birdY;
+            prevBirdRotation = sim.birdRotation;
         }
+        syncState();
+        applyEvents(events);
+    }
 
-        // Check collisions with ground or ceiling
-        if (bird.getPosition().y <= 0 ||
-            bird.getPosition().y + bird.getGlobalBounds().height / 2 >= WINDOW_HEIGHT) {
-            lives--;
-            if (lives <= 0) {
-                gameOver = true;
-                if (!musicMuted) gameOverSound.play();
-                saveHighScore();
-            }
-            else {
-                // Reset bird position
-                bird.setPosition(
-                    static_cast<float>(WINDOW_WIDTH) / 4.0f,
-                    static_cast<float>(WINDOW_HEIGHT) / 2.0f
-                );
-                birdVelocity = 0.f;
-                bird.setRotation(0);
-            }
-        }
-
-        // Pipe spawning
-        pipeSpawnTimer += 0.01f;
-        if (pipeSpawnTimer >= pipeSpawnDelay) {
-            pipeSpawnTimer = 0;
-            spawnPipe();
-        }
-
-        // Pipe movement and collision
-        for (auto it = pipes.begin(); it != pipes.end(); ) {
-            it->move(-pipeSpeed, 0);
-
-            // Check collision with bird
-            if (bird.getGlobalBounds().intersects(it->getGlobalBounds())) {
-                lives--;
-                if (lives <= 0) {
-                    gameOver = true;
-                    if (!musicMuted) gameOverSound.play();
-                    saveHighScore();
-                }
-                else {
-                    // Reset bird position
-                    bird.setPosition(
-                        static_cast<float>(WINDOW_WIDTH) / 4.0f,
-                        static_cast<float>(WINDOW_HEIGHT) / 2.0f
-                    );
-                    birdVelocity = 0.f;
-                    bird.setRotation(0);
-                    it = pipes.erase(it);
-                    continue;
-                }
-            }
-
-            // Check if bird passed the pipe
-            if (!passedPipe && it->getPosition().x + it->getSize().x < bird.getPosition().x) {
-                passedPipe = true;
-                if (!musicMuted) pointSound.play();
-                score += 5;
-            }
+    void draw(float alpha) override {
+        Game::draw(alpha);
 
-            // Remove off-screen pipes
-            if (it->getPosition().x + it->getSize().x < 0) {
-                it = pipes.erase(it);
-                passedPipe = false;
-            }
-            else {
-                ++it;
-            }
-        }
-    }
+        // Pipes only ever move left at a constant speed, so one tick ago they were pipeSpeed further right
+        float pipeOffset = gameOver ? 0.f : sim.pipeSpeed * (1.f - alpha);
 
-    void draw() override {
-        Game::draw();
+        // Draw pipes, moving every frame so the batch is rebuilt every frame
+        pipeBatch.clear();
+        for (uint32_t i = sim.firstPipe; i != sim.pipeEnd; ++i) {
+            const PipePair& pipe = sim.pipe(i);
+            if (pipe.hit) continue;
+            float x = pipe.x + pipeOffset;
 
-        // Draw pipes
-        for (auto& pipe : pipes) {
-            window.draw(pipe);
+            pipeBatch.addRect(x, 0.0f, PIPE_WIDTH, pipe.gapTop, sf::Color::Green); // Upper pipe
+            pipeBatch.addRect(x, pipe.gapBottom, PIPE_WIDTH, static_cast<float>(WINDOW_HEIGHT) - pipe.gapBottom, sf::Color::Green); // Lower pipe
         }
+        pipeBatch.draw(window);
 
         // Draw bird
-        window.draw(bird);
+        bird.setPosition(BIRD_X, prevBirdY + (sim.birdY - prevBirdY) * alpha);
+        bird.setRotation(prevBirdRotation + (sim.birdRotation - prevBirdRotation) * alpha);
+        drawCounted(window, bird);
 
         // Draw UI
-        sf::Text scoreText;
-        scoreText.setFont(font);
-        scoreText.setString("Score: " + std::to_string(score));
-        scoreText.setCharacterSize(20);
-        scoreText.setFillColor(sf::Color::White);
-        scoreText.setPosition(10, 10);
-        window.draw(scoreText);
-
-        sf::Text highScoreText;
-        highScoreText.setFont(font);
-        highScoreText.setString("High Score: " + std::to_string(highScore));
-        highScoreText.setCharacterSize(20);
-        highScoreText.setFillColor(sf::Color::White);
-        highScoreText.setPosition(10, 40);
-        window.draw(highScoreText);
-
-        sf::Text livesText;
-        livesText.setFont(font);
-        livesText.setString("Lives: " + std::to_string(lives));
-        livesText.setCharacterSize(20);
-        livesText.setFillColor(sf::Color::White);
-        livesText.setPosition(10, 70);
-        window.draw(livesText);
-
-        if (gameOver) {
-            sf::Text gameOverText;
-            gameOverText.setFont(font);
-            gameOverText.setString("GAME OVER\nPress R to Restart\nPress M for Menu");
-            gameOverText.setCharacterSize(30);
-            gameOverText.setFillColor(sf::Color::Red);
-            gameOverText.setPosition(
-                static_cast<float>(WINDOW_WIDTH) / 2.0f - gameOverText.getLocalBounds().width / 2.0f,
-                static_cast<float>(WINDOW_HEIGHT) / 2.0f - 50.0f
-            );
-            window.draw(gameOverText);
-        }
+        drawHud();
     }
 };
 
 // High Scores Screen
-class HighScoresScreen {
+class HighScoresScreen : public Scene {
 private:
-    sf::RenderWindow& window;
-    sf::Font font;
+    sf::RenderTarget& window; // the game window, or an offscreen texture when benchmarking
+    std::shared_ptr<const sf::Font> font;
     sf::Text title;
     sf::Text snakeHighScoreText;
+    sf::Text snakeEntriesText;
     sf::Text flappyHighScoreText;
+    sf::Text flappyEntriesText;
     sf::Text backText;
-    int snakeHighScore;
-    int flappyHighScore;
-    sf::Texture backgroundTexture;
-    sf::Sprite background;
+    Background background;
+
+    static const int SHOWN_ENTRIES = 5;
+
+    //"1. NAME  120" lines for the best few entries
+    static std::string formatEntries(const Leaderboard& board) {
+        std::ostringstream lines;
+        int rank = 0;
+        for (const auto& entry : board.entries()) {
+            if (rank == SHOWN_ENTRIES) break;
+            lines << ++rank << ". " << entry.name << "  " << entry.score << "\n";
+        }
+        if (rank == 0) lines << "No scores yet";
+        return lines.str();
+    }
+
+    void centerText(sf::Text& text, float y) {
+        text.setPosition(static_cast<float>(WINDOW_WIDTH) / 2.0f - text.getLocalBounds().width / 2.0f, y);
+    }
 
 public:
-    HighScoresScreen(sf::RenderWindow& win) : window(win), snakeHighScore(0), flappyHighScore(0) {
-        if (!font.loadFromFile("D:/happy/mycode/Assets/Font/Arcade_R.ttf")) {
-            std::cerr << "Failed to load font" << std::endl;
-        }
+    HighScoresScreen(sf::RenderTarget& win) : window(win) {
+        font = AssetCache::instance().getFont(ARCADE_FONT);
 
         // Load background (using menu background)
-        if (!backgroundTexture.loadFromFile(MENU_BACKGROUND)) {
-            std::cerr << "Failed to load background texture" << std::endl;
-        }
-        background.setTexture(backgroundTexture);
-        // Scale background to fit window
-        float scaleX = static_cast<float>(WINDOW_WIDTH) / backgroundTexture.getSize().x;
-        float scaleY = static_cast<float>(WINDOW_HEIGHT) / backgroundTexture.getSize().y;
-        background.setScale(scaleX, scaleY);
+        background.load(MENU_BACKGROUND);
 
-        loadHighScores();
         setupText();
+        refresh();
     }
-    // function to update display high score 
-    void loadHighScores() {
-        std::ifstream snakeFile(SNAKE_HIGHSCORE_FILE);
-        if (snakeFile.is_open()) {
-            snakeFile >> snakeHighScore;
-            snakeFile.close();
-        }
 
-        std::ifstream flappyFile(FLAPPY_HIGHSCORE_FILE);
-        if (flappyFile.is_open()) {
-            flappyFile >> flappyHighScore;
-            flappyFile.close();
-        }
+    // function to update display high score, reads the in-memory leaderboards so it never touches disk
+    void refresh() {
+        Leaderboard& snake = Leaderboards::instance().get(GAME_SNAKE);
+        Leaderboard& flappy = Leaderboards::instance().get(GAME_FLAPPY);
+
+        snakeHighScoreText.setString("Eat The Emoji: " + std::to_string(snake.best()));
+        centerText(snakeHighScoreText, 180.0f);
+        snakeEntriesText.setString(formatEntries(snake));
+        centerText(snakeEntriesText, 225.0f);
+
+        flappyHighScoreText.setString("Basim Bird: " + std::to_string(flappy.best()));
+        centerText(flappyHighScoreText, 380.0f);
+        flappyEntriesText.setString(formatEntries(flappy));
+        centerText(flappyEntriesText, 425.0f);
     }
 
     void setupText() {
-        title.setFont(font);
+        title.setFont(*font);
         title.setString("HIGH SCORES");
         title.setCharacterSize(50);
         title.setFillColor(sf::Color::Cyan);
-        title.setPosition(
-            static_cast<float>(WINDOW_WIDTH) / 2.0f - title.getLocalBounds().width / 2.0f,
-            100.0f
-        );
-
-        snakeHighScoreText.setFont(font);
-        snakeHighScoreText.setString("Eat The Emoji: " + std::to_string(snakeHighScore));
-        snakeHighScoreText.setCharacterSize(30);
-        snakeHighScoreText.setFillColor(sf::Color::White);
-        snakeHighScoreText.setPosition(
-            static_cast<float>(WINDOW_WIDTH) / 2.0f - snakeHighScoreText.getLocalBounds().width / 2.0f,
-            200.0f
-        );
+        centerText(title, 100.0f);
 
-        flappyHighScoreText.setFont(font);
-        flappyHighScoreText.setString("Basim Bird: " + std::to_string(flappyHighScore));
-        flappyHighScoreText.setCharacterSize(30);
-        flappyHighScoreText.setFillColor(sf::Color::White);
-        flappyHighScoreText.setPosition(
-            static_cast<float>(WINDOW_WIDTH) / 2.0f - flappyHighScoreText.getLocalBounds().width / 2.0f,
-            250.0f
-        );
+        for (sf::Text* heading : { &snakeHighScoreText, &flappyHighScoreText }) {
+            heading->setFont(*font);
+            heading->setCharacterSize(30);
+            heading->setFillColor(sf::Color::White);
+        }
+        for (sf::Text* entries : { &snakeEntriesText, &flappyEntriesText }) {
+            entries->setFont(*font);
+            entries->setCharacterSize(20);
+            entries->setFillColor(sf::Color::White);
+        }
 
-        backText.setFont(font);
+        backText.setFont(*font);
         backText.setString("Press B to go back");
         backText.setCharacterSize(20);
         backText.setFillColor(sf::Color::White);
-        backText.setPosition(
-            static_cast<float>(WINDOW_WIDTH) / 2.0f - backText.getLocalBounds().width / 2.0f,
-            350.0f
-        );
+        centerText(backText, 600.0f);
+    }
+
+    //scores may have changed since the screen was last up
+    void resume() override {
+        refresh();
     }
 
-    void handleInput(bool& showHighScores) {
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::B)) {
-            showHighScores = false;
+    void handleInput() override {
+        if (InputState::instance().consumePress(sf::Keyboard::B)) {
+            closeRequested = true;
         }
     }
 
-    void draw() {
-        window.draw(background);
-        window.draw(title);
-        window.draw(snakeHighScoreText);
-        window.draw(flappyHighScoreText);
-        window.draw(backText);
+    void draw(float) override {
+        background.draw(window);
+        drawCounted(window, title);
+        drawCounted(window, snakeHighScoreText);
+        drawCounted(window, snakeEntriesText);
+        drawCounted(window, flappyHighScoreText);
+        drawCounted(window, flappyEntriesText);
+        drawCounted(window, backText);
     }
 };
 
 // Instructions Screen
-class InstructionsScreen {
+class InstructionsScreen : public Scene {
 private:
-    sf::RenderWindow& window;
-    sf::Font font;
+    sf::RenderTarget& window; // the game window, or an offscreen texture when benchmarking
+    std::shared_ptr<const sf::Font> font;
     sf::Text title;
     sf::Text snakeInstructions;
     sf::Text flappyInstructions;
     sf::Text backText;
-    sf::Texture backgroundTexture;
-    sf::Sprite background;
+    Background background;
 
 public:
-    InstructionsScreen(sf::RenderWindow& win) : window(win) {
-        if (!font.loadFromFile("D:/happy/mycode/Assets/Font/Arcade_R.ttf")) {
-            std::cerr << "Failed to load font" << std::endl;
-        }
+    InstructionsScreen(sf::RenderTarget& win) : window(win) {
+        font = AssetCache::instance().getFont(ARCADE_FONT);
 
         // Load background (using menu background)
-        if (!backgroundTexture.loadFromFile(MENU_BACKGROUND)) {
-            std::cerr << "Failed to load background texture" << std::endl;
-        }
-        background.setTexture(backgroundTexture);
-        // Scale background to fit window
-        float scaleX = static_cast<float>(WINDOW_WIDTH) / backgroundTexture.getSize().x;
-        float scaleY = static_cast<float>(WINDOW_HEIGHT) / backgroundTexture.getSize().y;
-        background.setScale(scaleX, scaleY);
+        background.load(MENU_BACKGROUND);
 
         setupText();
     }
 
     void setupText() {
-        title.setFont(font);
+        title.setFont(*font);
         title.setString("\n\nINSTRUCTIONS");
         title.setCharacterSize(50);
         title.setFillColor(sf::Color::Cyan);
@@ -720,11 +1681,11 @@ public:
             50.0f
         );
 
-        snakeInstructions.setFont(font);
+        snakeInstructions.setFont(*font);
         snakeInstructions.setString(
             "\n\n\n\n\n\t---EAT THE EMOJI---\n"
             "Use arrow keys to move\n"
-            "Eat red food to grow\n"
+            "Move onto the food to grow\n"
             "Don't hit walls or yourself\n"
             "You have 3 lives\n"
         );
@@ -735,12 +1696,13 @@ public:
             120.0f
         );
 
-        flappyInstructions.setFont(font);
+        flappyInstructions.setFont(*font);
         flappyInstructions.setString(
             "\n\n\n\n\n\n\t\t  ---BASIM BIRD---\n"
             "\tPress SPACE to jump\n"
             "\tNavigate through pipes\n"
             "\tEach passed pipe gives 5 points\n"
+            "\tHitting a pipe clears that pair\n"
             "\tYou have 3 lives\n"
         );
         flappyInstructions.setCharacterSize(20);
@@ -750,7 +1712,7 @@ public:
             250.0f
         );
 
-        backText.setFont(font);
+        backText.setFont(*font);
         backText.setString("\n\n\n\n\n\n\n\n\n\nPress B to go back");
         backText.setCharacterSize(20);
         backText.setFillColor(sf::Color::White);
@@ -760,26 +1722,70 @@ public:
         );
     }
 
-    void handleInput(bool& showInstructions) {
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::B)) {
-            showInstructions = false;
+    void handleInput() override {
+        if (InputState::instance().consumePress(sf::Keyboard::B)) {
+            closeRequested = true;
         }
     }
 
-    void draw() {
-        window.draw(background);
-        window.draw(title);
-        window.draw(snakeInstructions);
-        window.draw(flappyInstructions);
-        window.draw(backText);
+    void draw(float) override {
+        background.draw(window);
+        drawCounted(window, title);
+        drawCounted(window, snakeInstructions);
+        drawCounted(window, flappyInstructions);
+        drawCounted(window, backText);
+    }
+};
+
+// Loading Screen, shown while assets decode in the background
+class LoadingScreen {
+private:
+    sf::RenderTarget& window; // the game window, or an offscreen texture when benchmarking
+    std::shared_ptr<const sf::Font> font;
+    sf::Text title;
+    sf::RectangleShape barOutline;
+    sf::RectangleShape barFill;
+
+    static constexpr float BAR_WIDTH = 400.f;
+    static constexpr float BAR_HEIGHT = 24.f;
+
+public:
+    LoadingScreen(sf::RenderTarget& win) : window(win) {
+        font = AssetCache::instance().getFont(ARCADE_FONT);
+
+        title.setFont(*font);
+        title.setString("LOADING");
+        title.setCharacterSize(40);
+        title.setFillColor(sf::Color::Cyan);
+        title.setPosition(
+            static_cast<float>(WINDOW_WIDTH) / 2.0f - title.getLocalBounds().width / 2.0f,
+            static_cast<float>(WINDOW_HEIGHT) / 2.0f - 100.0f
+        );
+
+        sf::Vector2f barPosition(static_cast<float>(WINDOW_WIDTH) / 2.0f - BAR_WIDTH / 2.0f, static_cast<float>(WINDOW_HEIGHT) / 2.0f);
+        barOutline.setSize(sf::Vector2f(BAR_WIDTH, BAR_HEIGHT));
+        barOutline.setPosition(barPosition);
+        barOutline.setFillColor(sf::Color::Transparent);
+        barOutline.setOutlineColor(sf::Color::White);
+        barOutline.setOutlineThickness(2.f);
+        barFill.setPosition(barPosition);
+        barFill.setFillColor(sf::Color::Cyan);
+    }
+
+    //progress is 0..1
+    void draw(float progress) {
+        barFill.setSize(sf::Vector2f(BAR_WIDTH * std::min(std::max(progress, 0.f), 1.f), BAR_HEIGHT));
+        drawCounted(window, title);
+        drawCounted(window, barFill);
+        drawCounted(window, barOutline);
     }
 };
 
 // Main Menu
-class MainMenu {
+class MainMenu : public Scene {
 private:
-    sf::RenderWindow& window;
-    sf::Font font;
+    sf::RenderTarget& window; // the game window, or an offscreen texture when benchmarking
+    std::shared_ptr<const sf::Font> font;
     sf::Text title;
     sf::Text snakeText;
     sf::Text flappyText;
@@ -788,35 +1794,22 @@ private:
     sf::Text exitText;
     int selectedItem;
     std::vector<sf::Text> menuItems;
-    sf::Clock keyPressClock;
-    float keyPressDelay;
-    bool keyProcessed;
-    sf::Texture backgroundTexture;
-    sf::Sprite background;
+    Background background;
 
 public:
-    MainMenu(sf::RenderWindow& win)
-        : window(win), selectedItem(0), keyPressDelay(0.2f), keyProcessed(false) {
-        if (!font.loadFromFile("D:/happy/mycode/Assets/Font/Arcade_R.ttf")) {
-            std::cerr << "Failed to load font" << std::endl;
-        }
+    MainMenu(sf::RenderTarget& win)
+        : window(win), selectedItem(0) {
+        font = AssetCache::instance().getFont(ARCADE_FONT);
 
         // Load background
-        if (!backgroundTexture.loadFromFile(MENU_BACKGROUND)) {
-            std::cerr << "Failed to load background texture" << std::endl;
-        }
-        background.setTexture(backgroundTexture);
-        // Scale background to fit window
-        float scaleX = static_cast<float>(WINDOW_WIDTH) / backgroundTexture.getSize().x;
-        float scaleY = static_cast<float>(WINDOW_HEIGHT) / backgroundTexture.getSize().y;
-        background.setScale(scaleX, scaleY);
+        background.load(MENU_BACKGROUND);
 
         setupText();
         updateSelection();
     }
     // Function used to display all text throughout the code
     void setupText() {
-        title.setFont(font);
+        title.setFont(*font);
         title.setString("\n\nARCADE SIMULATOR");
         title.setCharacterSize(50);
         title.setFillColor(sf::Color::Cyan);
@@ -825,7 +1818,7 @@ public:
             50.0f
         );
 
-        snakeText.setFont(font);
+        snakeText.setFont(*font);
         snakeText.setString("\n\n\nEat The Emoji");
         snakeText.setCharacterSize(30);
         snakeText.setPosition(
@@ -833,7 +1826,7 @@ public:
             150.0f
         );
 
-        flappyText.setFont(font);
+        flappyText.setFont(*font);
         flappyText.setString("\n\n\nBasim Bird");
         flappyText.setCharacterSize(30);
         flappyText.setPosition(
@@ -841,7 +1834,7 @@ public:
             200.0f
         );
 
-        instructionsText.setFont(font);
+        instructionsText.setFont(*font);
         instructionsText.setString("\n\n\nInstructions");
         instructionsText.setCharacterSize(30);
         instructionsText.setPosition(
@@ -849,7 +1842,7 @@ public:
             250.0f
         );
 
-        highScoresText.setFont(font);
+        highScoresText.setFont(*font);
         highScoresText.setString("\n\n\nHigh Scores");
         highScoresText.setCharacterSize(30);
         highScoresText.setPosition(
@@ -857,7 +1850,7 @@ public:
             300.0f
         );
 
-        exitText.setFont(font);
+        exitText.setFont(*font);
         exitText.setString("\n\n\nExit");
         exitText.setCharacterSize(30);
         exitText.setPosition(
@@ -868,28 +1861,15 @@ public:
         menuItems = { snakeText, flappyText, instructionsText, highScoresText, exitText };
     }
     // Function to handel user input
-    void handleInput() {
-        if (keyPressClock.getElapsedTime().asSeconds() < keyPressDelay) {
-            return;
-        }
-
-        bool upPressed = sf::Keyboard::isKeyPressed(sf::Keyboard::Up);
-        bool downPressed = sf::Keyboard::isKeyPressed(sf::Keyboard::Down);
-
-        if ((upPressed || downPressed) && !keyProcessed) {
-            if (upPressed) {
-                selectedItem = (selectedItem - 1 + static_cast<int>(menuItems.size())) % static_cast<int>(menuItems.size());
-            }
-            else if (downPressed) {
-                selectedItem = (selectedItem + 1) % static_cast<int>(menuItems.size());
-            }
-
+    void handleInput() override {
+        InputState& input = InputState::instance();
+        if (input.consumePress(sf::Keyboard::Up)) {
+            selectedItem = (selectedItem - 1 + static_cast<int>(menuItems.size())) % static_cast<int>(menuItems.size());
             updateSelection();
-            keyPressClock.restart();
-            keyProcessed = true;
         }
-        else if (!upPressed && !downPressed) {
-            keyProcessed = false;
+        if (input.consumePress(sf::Keyboard::Down)) {
+            selectedItem = (selectedItem + 1) % static_cast<int>(menuItems.size());
+            updateSelection();
         }
     }
     
@@ -908,117 +1888,1001 @@ public:
         return selectedItem;
     }
     // Function to render background and Title
-    void draw() {
-        window.draw(background);
-        window.draw(title);
+    void draw(float) override {
+        background.draw(window);
+        drawCounted(window, title);
         for (const auto& item : menuItems) {
-            window.draw(item);
+            drawCounted(window, item);
+        }
+    }
+};
+
+// F3 overlay with frame-time percentiles from the profiler
+class ProfilerOverlay {
+private:
+    sf::Text text;
+    sf::RectangleShape panel;
+    std::shared_ptr<const sf::Font> font;
+    bool visible;
+    int framesUntilRefresh;
+
+    static const int REFRESH_FRAMES = 15; // percentiles are re-read a few times a second, not every frame
+
+    void refresh() {
+        const Profiler& profiler = Profiler::instance();
+        std::ostringstream lines;
+        lines << std::fixed << std::setprecision(2) << "ms        p50    p99    max\n";
+        for (int scope = 0; scope < PROFILE_SCOPE_COUNT; ++scope) {
+            ProfileSummary summary = profiler.summarize(static_cast<ProfileScope>(scope));
+            lines << std::left << std::setw(8) << profileScopeName(static_cast<ProfileScope>(scope)) << std::right
+                << std::setw(7) << summary.p50 << std::setw(7) << summary.p99 << std::setw(7) << summary.max << "\n";
+        }
+        text.setString(lines.str());
+        sf::FloatRect bounds = text.getLocalBounds();
+        panel.setSize(sf::Vector2f(bounds.width + 20.f, bounds.height + 20.f));
+    }
+
+public:
+    ProfilerOverlay() : visible(false), framesUntilRefresh(0) {
+        font = AssetCache::instance().getFont(ARCADE_FONT);
+        text.setFont(*font);
+        text.setCharacterSize(14);
+        text.setFillColor(sf::Color::Yellow);
+        text.setPosition(15.f, 15.f);
+        panel.setPosition(5.f, 5.f);
+        panel.setFillColor(sf::Color(0, 0, 0, 170));
+    }
+
+    void toggle() {
+        visible = !visible;
+        framesUntilRefresh = 0;
+    }
+
+    void draw(sf::RenderTarget& target) {
+        if (!visible) return;
+        if (--framesUntilRefresh <= 0) {
+            refresh();
+            framesUntilRefresh = REFRESH_FRAMES;
+        }
+        drawCounted(target, panel);
+        drawCounted(target, text);
+    }
+};
+
+// Fixed-step accumulator: real time is banked every frame and paid out in whole simulation ticks,
+// so gameplay is the same whatever the render rate
+class FixedTimestep {
+private:
+    double tickLength;
+    int maxTicksPerFrame;
+    double accumulator;
+    sf::Clock clock;
+    uint64_t droppedTicks;
+
+public:
+    FixedTimestep(int ticksPerSecond, int maxCatchUp)
+        : tickLength(1.0 / ticksPerSecond), maxTicksPerFrame(maxCatchUp), accumulator(0.0), droppedTicks(0) {}
+
+    //returns how many ticks the simulation owes for the time since the last frame
+    int beginFrame() {
+        accumulator += clock.restart().asSeconds();
+
+        int ticks = static_cast<int>(accumulator / tickLength);
+        if (ticks > maxTicksPerFrame) {
+            // too far behind (long stall or a slow machine), give up on the backlog instead of spiralling
+            droppedTicks += ticks - maxTicksPerFrame;
+            ticks = maxTicksPerFrame;
+            accumulator = 0.0;
+        }
+        else {
+            accumulator -= ticks * tickLength;
         }
+        return ticks;
+    }
+
+    //forgets time spent away from the game (menus, loading) so it doesn't get replayed as a burst of ticks
+    void resync() {
+        accumulator = 0.0;
+        clock.restart();
     }
+
+    float getAlpha() const { return static_cast<float>(accumulator / tickLength); }
+    uint64_t getDroppedTicks() const { return droppedTicks; }
 };
 
-int main() {
+// Benchmarks: the simulation and rendering hot paths timed in isolation, so regressions show up as numbers
+struct BenchResult {
+    std::string name;
+    std::string param; // what value varies, empty when nothing does
+    int value;
+    uint64_t iterations;
+    double nsPerOp;
+    double drawCalls; // per frame, -1 for benchmarks that don't draw
+    double textureBinds;
+};
+
+//heads clockwise round the edge of the board, a snake shorter than the edge never runs into itself
+SnakeDirection snakeEdgeDirection(const SnakeCell& head, SnakeDirection current) {
+    if (head.y == 0 && head.x < SNAKE_COLS - 1) return DIR_RIGHT;
+    if (head.x == SNAKE_COLS - 1 && head.y < SNAKE_ROWS - 1) return DIR_DOWN;
+    if (head.y == SNAKE_ROWS - 1 && head.x > 0) return DIR_LEFT;
+    if (head.x == 0 && head.y > 0) return DIR_UP;
+    return current;
+}
+
+//a snake of the given length circling the edge of the board, with the food parked out of its way
+SnakeSim edgeSnake(int length) {
+    SnakeSim sim(1);
+    while (sim.length < length && !sim.gameOver) {
+        // keep putting food right where the head goes next until it has grown enough
+        SnakeDirection next = snakeEdgeDirection(sim.segment(0), sim.direction);
+        sim.foodX = sim.segment(0).x + directionX(next);
+        sim.foodY = sim.segment(0).y + directionY(next);
+        sim.step(directionInput(next));
+    }
+    sim.foodX = SNAKE_COLS / 4;
+    sim.foodY = SNAKE_ROWS / 2;
+    // go round until the tail has left the middle of the board too
+    for (int i = 0; i < (length + SNAKE_COLS) * sim.moveTicks; ++i) {
+        sim.step(directionInput(snakeEdgeDirection(sim.segment(0), sim.direction)));
+    }
+    return sim;
+}
+
+//a fresh flappy game with count pipes spread across the screen and gaps too wide to hit
+FlappySim flappyWithPipes(int count) {
+    FlappySim sim(1);
+    float spacing = (WINDOW_WIDTH + PIPE_WIDTH) / static_cast<float>(std::max(count, 1));
+    for (int i = 0; i < count; ++i) {
+        float x = -PIPE_WIDTH + (i + 1) * spacing - 1.f;
+        sim.pipe(sim.pipeEnd++) = { x, 10.f, WINDOW_HEIGHT - 10.f, false };
+        if (x + PIPE_WIDTH < BIRD_X) sim.nextScore = sim.pipeEnd;
+    }
+    return sim;
+}
+
+template <typename Run>
+BenchResult timeBench(const std::string& name, const std::string& param, int value, uint64_t iterations, Run run) {
+    sf::Clock clock;
+    run(iterations);
+    double elapsed = clock.getElapsedTime().asMicroseconds() * 1000.0;
+    return { name, param, value, iterations, elapsed / static_cast<double>(iterations), -1.0, -1.0 };
+}
+
+//times frames drawn into an offscreen texture, reading the texture back at the end so the GPU work is counted
+template <typename Draw>
+BenchResult timeDraw(sf::RenderTexture& target, const std::string& name, int frames, Draw draw) {
+    for (int i = 0; i < 10; ++i) { // warm up caches and driver state
+        target.clear();
+        draw();
+        target.display();
+    }
+    RenderStats::instance().drawCalls = 0;
+    RenderStats::instance().textureBinds = 0;
+    sf::Clock clock;
+    for (int i = 0; i < frames; ++i) {
+        target.clear();
+        draw();
+        target.display();
+    }
+    sf::Image finished = target.getTexture().copyToImage();
+    double elapsed = clock.getElapsedTime().asMicroseconds() * 1000.0;
+    double drawCalls = static_cast<double>(RenderStats::instance().drawCalls) / frames;
+    double textureBinds = static_cast<double>(RenderStats::instance().textureBinds) / frames;
+    RenderStats::instance().drawCalls = 0;
+    RenderStats::instance().textureBinds = 0;
+    return { name, "", 0, static_cast<uint64_t>(frames), elapsed / frames, drawCalls, textureBinds };
+}
+
+bool writeBenchResults(const std::vector<BenchResult>& results, const std::string& path) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) return false;
+    bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    file << std::fixed << std::setprecision(2);
+    if (json) {
+        file << "{\"benchmarks\":[\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const BenchResult& result = results[i];
+            file << "{\"name\":\"" << result.name << "\",\"param\":\"" << result.param << "\",\"value\":" << result.value
+                << ",\"iterations\":" << result.iterations << ",\"ns_per_op\":" << result.nsPerOp
+                << ",\"draw_calls\":" << result.drawCalls << ",\"texture_binds\":" << result.textureBinds << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        file << "]}\n";
+    }
+    else {
+        file << "name,param,value,iterations,ns_per_op,draw_calls,texture_binds\n";
+        for (const auto& result : results) {
+            file << result.name << ',' << result.param << ',' << result.value << ',' << result.iterations << ','
+                << result.nsPerOp << ',' << result.drawCalls << ',' << result.textureBinds << '\n';
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+int runBenchmarks(const std::string& outPath) {
+    std::vector<BenchResult> results;
+    volatile int sink = 0; // keeps the optimizer from dropping the work
+
+    // Snake tick cost against length
+    for (int length : { SNAKE_START_LENGTH, 10, 50, 100 }) {
+        SnakeSim start = edgeSnake(length);
+        results.push_back(timeBench("snake_tick", "length", length, 2000000, [&](uint64_t ticks) {
+            SnakeSim sim = start;
+            for (uint64_t i = 0; i < ticks; ++i) {
+                sim.step(directionInput(snakeEdgeDirection(sim.segment(0), sim.direction)));
+            }
+            if (sim.gameOver || sim.length != length) std::cerr << "snake_tick: snake of length " << length << " didn't survive" << std::endl;
+            sink = sink + sim.score;
+        }));
+    }
+
+    // Snake ticks played by the autopilot, planning included, from a fresh game until the snake is long
+    std::unique_ptr<SnakeAutopilot> pilot(new SnakeAutopilot());
+    std::unique_ptr<SnakeSim> piloted(new SnakeSim(1));
+    results.push_back(timeBench("snake_autopilot", "ticks", 200000, 200000, [&](uint64_t ticks) {
+        for (uint64_t i = 0; i < ticks && !piloted->gameOver; ++i) piloted->step(pilot->next(*piloted));
+        sink = sink + piloted->score;
+    }));
+    const AutopilotStats& pilotStats = pilot->getStats();
+    std::cout << std::fixed << std::setprecision(2) << "Snake autopilot: length " << piloted->length << ", " << pilotStats.plans << " plans, "
+        << pilotStats.repairs << " repairs, " << pilotStats.fallbacks << " stalling moves, planning " << pilotStats.averageMicros()
+        << "us/tick avg, " << pilotStats.maxMicros() << "us max" << std::defaultfloat << std::endl;
+
+    // Flappy tick cost against pipes on screen, each batch starts over before the bird hits the ground
+    const int FLAPPY_BATCH_TICKS = 30;
+    for (int count : { 0, 1, 2, 4, 8, static_cast<int>(PIPE_POOL_SIZE) }) {
+        FlappySim start = flappyWithPipes(count);
+        results.push_back(timeBench("flappy_tick", "pipes", count, 2000000, [&](uint64_t ticks) {
+            for (uint64_t i = 0; i < ticks; i += FLAPPY_BATCH_TICKS) {
+                FlappySim sim = start;
+                for (int tick = 0; tick < FLAPPY_BATCH_TICKS; ++tick) sim.step(INPUT_NONE);
+                sink = sink + sim.score + sim.lives;
+            }
+        }));
+    }
+
+    // Many flappy worlds per world-tick, stepped one FlappySim at a time and as one FlappyBatch.
+    // Both get the same inputs, and finish in the same state or the batch is reported as wrong
+    const size_t WORLDS = 4096;
+    const uint64_t WORLD_TICKS = WORLDS * 1000;
+    std::vector<FlappySim> worlds;
+    for (size_t world = 0; world < WORLDS; ++world) worlds.emplace_back(world);
+    FlappyBatch batch(WORLDS);
+    std::vector<uint8_t> inputs(WORLDS), events(WORLDS);
+    auto worldInputs = [&](uint64_t tick) {
+        for (size_t world = 0; world < WORLDS; ++world) inputs[world] = (tick + world) % 39 == 0 ? INPUT_FLAP : INPUT_NONE;
+    };
+    results.push_back(timeBench("flappy_worlds", "worlds", static_cast<int>(WORLDS), WORLD_TICKS, [&](uint64_t worldTicks) {
+        for (uint64_t tick = 0; tick < worldTicks / WORLDS; ++tick) {
+            worldInputs(tick);
+            for (size_t world = 0; world < WORLDS; ++world) events[world] = worlds[world].step(inputs[world]);
+        }
+    }));
+    results.push_back(timeBench("flappy_batch", "worlds", static_cast<int>(WORLDS), WORLD_TICKS, [&](uint64_t worldTicks) {
+        for (uint64_t tick = 0; tick < worldTicks / WORLDS; ++tick) {
+            worldInputs(tick);
+            batch.step(inputs.data(), events.data());
+        }
+    }));
+    for (size_t world = 0; world < WORLDS; ++world) {
+        FlappySim batched = batch.toSim(world);
+        if (batched.birdY != worlds[world].birdY || batched.score != worlds[world].score ||
+            batched.lives != worlds[world].lives || batched.ticks != worlds[world].ticks) {
+            std::cerr << "flappy_batch: world " << world << " doesn't match FlappySim" << std::endl;
+            break;
+        }
+    }
+    std::cout << "Flappy batch stepping " << BatchLanes::WIDTH << " worlds at a time (" << FlappyBatch::instructionSet() << ")" << std::endl;
+
+    // HUD text, rebuilt when a value changes and skipped when nothing did
+    std::shared_ptr<const sf::Font> font = AssetCache::instance().getFont(ARCADE_FONT);
+    Hud hud;
+    hud.setup(*font, sf::Color::White);
+    results.push_back(timeBench("hud_update", "changed", 1, 200000, [&](uint64_t calls) {
+        for (uint64_t i = 0; i < calls; ++i) hud.update(static_cast<int>(i), 100, 3, false);
+    }));
+    results.push_back(timeBench("hud_update", "changed", 0, 2000000, [&](uint64_t calls) {
+        for (uint64_t i = 0; i < calls; ++i) hud.update(42, 100, 3, false);
+    }));
+
+    // Every screen's draw() into an offscreen texture
+    sf::RenderTexture target;
+    if (!target.create(WINDOW_WIDTH, WINDOW_HEIGHT)) {
+        std::cerr << "Offscreen rendering unavailable (no GL context?), skipping draw benchmarks" << std::endl;
+    }
+    else {
+        const int FRAMES = 300;
+        MainMenu menu(target);
+        results.push_back(timeDraw(target, "draw_menu", FRAMES, [&]() { menu.draw(0.f); }));
+        InstructionsScreen instructions(target);
+        results.push_back(timeDraw(target, "draw_instructions", FRAMES, [&]() { instructions.draw(0.f); }));
+        HighScoresScreen highScores(target);
+        results.push_back(timeDraw(target, "draw_high_scores", FRAMES, [&]() { highScores.draw(0.f); }));
+
+        // A screen switch with its first frame, building the screen on the spot or flipping back to a
+        // kept one on the scene stack
+        results.push_back(timeDraw(target, "scene_switch_cold", FRAMES, [&]() {
+            MainMenu fresh(target);
+            fresh.draw(0.f);
+        }));
+        SceneManager scenes([&](SceneId id) -> std::unique_ptr<Scene> {
+            if (id == SCENE_INSTRUCTIONS) return std::make_unique<InstructionsScreen>(target);
+            return std::make_unique<MainMenu>(target);
+        });
+        scenes.push(SCENE_MENU);
+        scenes.prepare(SCENE_INSTRUCTIONS);
+        results.push_back(timeDraw(target, "scene_switch_warm", FRAMES, [&]() {
+            if (scenes.topId() == SCENE_MENU) scenes.push(SCENE_INSTRUCTIONS);
+            else scenes.pop();
+            scenes.top().draw(0.f);
+        }));
+
+        SnakeGame snake(target, 1);
+        results.push_back(timeDraw(target, "draw_snake", FRAMES, [&]() { snake.draw(0.5f); }));
+
+        // fly a few seconds on autopilot so there are pipes on screen
+        auto flight = std::make_shared<Replay>();
+        FlappySim pilot(1);
+        flight->start(GAME_FLAPPY, SIM_TICKS_PER_SECOND, pilot.seed);
+        for (int tick = 0; tick < 600; ++tick) {
+            uint8_t bits = flappyAutopilot(pilot);
+            flight->record(bits);
+            pilot.step(bits);
+        }
+        flight->finish(pilot.score);
+        FlappyBirdGame flappy(target, 1);
+        flappy.playBack(flight);
+        flappy.reset();
+        for (int tick = 0; tick < 600; ++tick) flappy.update();
+        results.push_back(timeDraw(target, "draw_flappy", FRAMES, [&]() { flappy.draw(0.5f); }));
+    }
+
+    for (const auto& result : results) {
+        std::cout << std::left << std::setw(20) << result.name << std::setw(10) << result.param << std::right << std::setw(6);
+        if (result.param.empty()) std::cout << ""; else std::cout << result.value;
+        std::cout << std::setw(14) << std::fixed << std::setprecision(1) << result.nsPerOp << " ns/op";
+        if (result.drawCalls >= 0) std::cout << std::setw(8) << result.drawCalls << " draws" << std::setw(6) << result.textureBinds << " binds";
+        std::cout << std::endl;
+    }
+    if (!outPath.empty() && !writeBenchResults(results, outPath)) {
+        std::cerr << "Failed to write benchmark results: " << outPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Headless soak test: steps both simulations with random input and no window at all
+void runSoak(uint64_t ticks, uint64_t seed) {
+    SimRandom gen(seed);
+    SnakeSim snake(gen.next64());
+    FlappySim flappy(gen.next64());
+    uint64_t snakeGames = 0, flappyGames = 0;
+    long long snakePoints = 0, flappyPoints = 0;
+
+    sf::Clock clock;
+    uint64_t allocationsBefore = heapAllocations.load(std::memory_order_relaxed);
+    for (uint64_t i = 0; i < ticks; ++i) {
+        uint32_t bits = gen.next();
+        snake.step(static_cast<uint8_t>(1u << (bits % 4))); // one arrow key per tick
+        flappy.step((bits & 0x70) == 0 ? INPUT_FLAP : INPUT_NONE); // flap on roughly 1 tick in 8
+
+        if (snake.gameOver) {
+            snakePoints += snake.score;
+            snakeGames++;
+            snake.reset(gen.next64());
+        }
+        if (flappy.gameOver) {
+            flappyPoints += flappy.score;
+            flappyGames++;
+            flappy.reset(gen.next64());
+        }
+    }
+    float elapsed = clock.getElapsedTime().asSeconds();
+    uint64_t allocations = heapAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+
+    std::cout << "Soaked " << ticks << " ticks of each game in " << elapsed << "s ("
+        << static_cast<double>(ticks) * 2.0 / (elapsed > 0 ? elapsed : 1e-6f) << " ticks/s)" << std::endl;
+    std::cout << "Snake: " << snakeGames << " games, " << snakePoints << " points" << std::endl;
+    std::cout << "Flappy: " << flappyGames << " games, " << flappyPoints << " points" << std::endl;
+    std::cout << "Heap allocations while soaking: " << allocations << std::endl;
+}
+
+// Re-simulates a recorded round without a window and checks it ends with the recorded score
+int runReplayCheck(const Replay& replay) {
+    sf::Clock clock;
+    ReplayResult result;
+    bool valid = verifyReplay(replay, &result);
+    float elapsed = clock.getElapsedTime().asSeconds();
+
+    double gameSeconds = static_cast<double>(result.ticks) / replay.tickRate;
+    std::cout << gameName(replay.game) << " replay: " << result.ticks << " ticks re-simulated in " << elapsed * 1000.f << "ms ("
+        << gameSeconds / (elapsed > 0 ? elapsed : 1e-6f) << "x real time)" << std::endl;
+    std::cout << "Recorded score " << replay.finalScore << ", re-simulated score " << result.score
+        << (valid ? " - verified" : " - MISMATCH") << std::endl;
+    return valid ? 0 : 1;
+}
+
+// Verifies every replay in a directory on all cores and only accepts the scores it can reproduce
+int runVerifier(const std::string& dir, int threadCount) {
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".rpl") {
+            paths.push_back(entry.path().string());
+        }
+    }
+    if (error) {
+        std::cerr << "Failed to read replay directory: " << dir << std::endl;
+        return 1;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    struct Outcome {
+        bool loaded;
+        bool valid;
+        GameKind game;
+        int score;
+        uint32_t ticks;
+        uint64_t hash;
+    };
+    std::vector<Outcome> outcomes(paths.size());
+    std::atomic<size_t> nextJob(0);
+
+    // workers pull the next unclaimed replay until the list runs out
+    auto worker = [&]() {
+        Replay replay;
+        for (size_t i = nextJob++; i < paths.size(); i = nextJob++) {
+            Outcome& outcome = outcomes[i];
+            outcome = { false, false, GAME_SNAKE, 0, 0, 0 };
+            // submissions are untrusted, a file that throws is rejected as unreadable instead of ending the run
+            try {
+                if (!replay.load(paths[i])) continue;
+
+                ReplayResult result;
+                outcome.loaded = true;
+                outcome.valid = verifyReplay(replay, &result);
+                outcome.game = replay.game;
+                outcome.score = replay.finalScore;
+                outcome.ticks = result.ticks;
+                outcome.hash = replay.hash();
+            }
+            catch (...) {
+                outcome = { false, false, GAME_SNAKE, 0, 0, 0 };
+                replay = Replay();
+            }
+        }
+    };
+
+    if (threadCount <= 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    sf::Clock clock;
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threadCount; ++t) {
+        pool.emplace_back(worker);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    float elapsed = std::max(clock.getElapsedTime().asSeconds(), 1e-6f);
+
+    int accepted = 0, rejected = 0;
+    uint64_t ticks = 0;
+    std::map<uint64_t, int> acceptedScores; // replay hash -> verified score
+    for (size_t i = 0; i < paths.size(); ++i) {
+        const Outcome& outcome = outcomes[i];
+        ticks += outcome.ticks;
+        if (!outcome.loaded) {
+            std::cout << "REJECTED (unreadable) " << paths[i] << std::endl;
+            rejected++;
+        }
+        else if (!outcome.valid) {
+            std::cout << "REJECTED (score " << outcome.score << " not reproduced) " << paths[i] << std::endl;
+            rejected++;
+        }
+        else {
+            accepted++;
+            acceptedScores[outcome.hash] = outcome.score;
+        }
+    }
+
+    std::cout << "Verified " << paths.size() << " sessions on " << threadCount << " threads in " << elapsed << "s: "
+        << accepted << " accepted, " << rejected << " rejected" << std::endl;
+    std::cout << "Throughput: " << paths.size() / elapsed << " sessions/s, " << ticks / elapsed << " ticks/s" << std::endl;
+
+    // a leaderboard entry only counts if an accepted session with its replay hash reached that score
+    for (GameKind game : { GAME_SNAKE, GAME_FLAPPY }) {
+        int backed = 0, unbacked = 0;
+        for (const auto& entry : Leaderboards::instance().get(game).entries()) {
+            auto found = acceptedScores.find(entry.replayHash);
+            if (entry.replayHash != 0 && found != acceptedScores.end() && found->second == entry.score) {
+                backed++;
+            }
+            else {
+                std::cout << gameName(game) << " leaderboard: " << entry.name << " " << entry.score << " is NOT backed by any replay" << std::endl;
+                unbacked++;
+            }
+        }
+        std::cout << gameName(game) << " leaderboard: " << backed << " entries backed by replays, " << unbacked << " not" << std::endl;
+    }
+    return rejected == 0 ? 0 : 1;
+}
+
+// Plays every registered bot on seedCount seeds, at 1, 2, 4... threads up to threadCount, and
+// prints how the tournament scales plus each bot's score and survival distribution
+int runTournamentMode(uint32_t seedCount, uint64_t firstSeed, int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<BotEntry> bots = tournamentBots();
+    std::vector<int> runs;
+    for (int threads = 1; threads < threadCount; threads *= 2) runs.push_back(threads);
+    runs.push_back(threadCount);
+
+    std::vector<TournamentResult> results;
+    bool consistent = true;
+    for (int threads : runs) {
+        TournamentResult result = runTournament(bots, seedCount, firstSeed, threads);
+        double speedup = results.empty() ? 1.0 : results.front().seconds / result.seconds;
+        std::cout << std::setw(3) << threads << " threads: " << std::fixed << std::setprecision(3) << result.seconds << "s, "
+            << std::setprecision(0) << result.matches / result.seconds << " matches/s, " << result.ticks / result.seconds << " ticks/s, "
+            << std::setprecision(2) << "speedup " << speedup << "x, efficiency " << std::setprecision(0) << 100.0 * speedup / threads << "%, "
+            << result.steals << " steals" << std::defaultfloat << std::endl;
+        if (!results.empty() && result.bots != results.front().bots) {
+            std::cerr << "Tournament results differ between 1 and " << threads << " threads" << std::endl;
+            consistent = false;
+        }
+        results.push_back(std::move(result));
+    }
+
+    std::cout << std::endl << std::left << std::setw(8) << "game" << std::setw(11) << "bot" << std::right
+        << std::setw(9) << "matches" << std::setw(8) << "mean" << std::setw(6) << "p50" << std::setw(6) << "p90" << std::setw(6) << "max"
+        << std::setw(10) << "surv(s)" << std::setw(6) << "p50" << std::setw(6) << "p90" << std::setw(8) << "capped" << std::endl;
+    const TournamentResult& result = results.back();
+    for (size_t bot = 0; bot < bots.size(); ++bot) {
+        const BotStats& stats = result.bots[bot];
+        std::cout << std::left << std::setw(8) << gameName(bots[bot].game) << std::setw(11) << bots[bot].name << std::right
+            << std::setw(9) << stats.matches << std::fixed << std::setprecision(1) << std::setw(8) << stats.meanScore()
+            << std::setw(6) << stats.scorePercentile(0.5) << std::setw(6) << stats.scorePercentile(0.9) << std::setw(6) << stats.scorePercentile(1.0)
+            << std::setw(10) << stats.meanSurvival() << std::setw(6) << stats.survivalPercentile(0.5) << std::setw(6) << stats.survivalPercentile(0.9)
+            << std::setw(8) << stats.capped << std::defaultfloat << std::endl;
+    }
+    return consistent ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    bool preloadAssets = false;
+    bool fixedSeed = false;
+    uint64_t seed = 0;
+    uint64_t soakTicks = 0;
+    bool headless = false;
+    std::string recordDir;
+    std::string replayPath;
+    std::string verifyDir;
+    uint32_t tournamentSeeds = 0;
+    int threadCount = 0; // 0 uses every core
+    int simHz = SIM_TICKS_PER_SECOND;
+    int maxCatchUp = 5; // at most this many ticks per rendered frame
+    int fpsLimit = 60; // 0 renders as fast as possible
+    std::string profileOut; // frame timings are written here on exit, CSV or .json Chrome trace
+    bool bench = false;
+    bool autopilot = false; // snake games start with the autopilot steering
+    std::string assetPath; // archive or directory, found automatically when empty
+    std::string packDir;
+    std::string packOut;
+    std::string benchOut;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--preload") {
+            preloadAssets = true;
+        }
+        else if (arg == "--sim-hz" && i + 1 < argc) {
+            simHz = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--max-catchup" && i + 1 < argc) {
+            maxCatchUp = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--fps" && i + 1 < argc) {
+            fpsLimit = std::max(0, std::stoi(argv[++i]));
+        }
+        else if (arg == "--soak" && i + 1 < argc) {
+            soakTicks = std::stoull(argv[++i]);
+        }
+        else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::stoull(argv[++i]);
+            fixedSeed = true;
+        }
+        else if (arg == "--record" && i + 1 < argc) {
+            recordDir = argv[++i];
+        }
+        else if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        }
+        else if (arg == "--headless") {
+            headless = true;
+        }
+        else if (arg == "--verify" && i + 1 < argc) {
+            verifyDir = argv[++i];
+        }
+        else if (arg == "--tournament" && i + 1 < argc) {
+            tournamentSeeds = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--name" && i + 1 < argc) {
+            Leaderboards::instance().setPlayerName(argv[++i]);
+        }
+        else if (arg == "--profile-out" && i + 1 < argc) {
+            profileOut = argv[++i];
+        }
+        else if (arg == "--assets" && i + 1 < argc) {
+            assetPath = argv[++i];
+        }
+        else if (arg == "--pack" && i + 2 < argc) {
+            packDir = argv[++i];
+            packOut = argv[++i];
+        }
+        else if (arg == "--autopilot") {
+            autopilot = true;
+        }
+        else if (arg == "--bench") {
+            bench = true;
+        }
+        else if (arg == "--bench-out" && i + 1 < argc) {
+            benchOut = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            threadCount = std::stoi(argv[++i]);
+        }
+    }
+
+    // Without --seed every game instance gets a fresh seed, with it runs repeat exactly
+    std::random_device entropy;
+    if (!fixedSeed) {
+        seed = (static_cast<uint64_t>(entropy()) << 32) | entropy();
+    }
+
+    if (!packDir.empty()) {
+        sf::Clock clock;
+        int packed = AssetArchive::pack(packDir, packOut);
+        if (packed < 0) return 1;
+        std::cout << "Packed " << packed << " files from " << packDir << " into " << packOut
+            << " in " << clock.getElapsedTime().asMilliseconds() << "ms" << std::endl;
+        return 0;
+    }
+
+    if (!assetPath.empty()) {
+        if (!AssetCache::instance().setAssetRoot(assetPath)) {
+            std::cerr << "Not an asset archive or directory: " << assetPath << std::endl;
+            return 1;
+        }
+    }
+    else {
+        AssetCache::instance().locateAssets(argc > 0 ? argv[0] : "");
+    }
+
+    if (soakTicks > 0) {
+        runSoak(soakTicks, seed);
+        return 0;
+    }
+    if (!verifyDir.empty()) {
+        return runVerifier(verifyDir, threadCount);
+    }
+    if (tournamentSeeds > 0) {
+        return runTournamentMode(tournamentSeeds, fixedSeed ? seed : 0, threadCount);
+    }
+    if (bench) {
+        return runBenchmarks(benchOut);
+    }
+
+    std::shared_ptr<Replay> replay;
+    if (!replayPath.empty()) {
+        replay = std::make_shared<Replay>();
+        if (!replay->load(replayPath)) {
+            std::cerr << "Failed to load replay: " << replayPath << std::endl;
+            return 1;
+        }
+        if (headless) {
+            return runReplayCheck(*replay);
+        }
+        simHz = replay->tickRate; // the replay only reproduces at the rate it was recorded at
+    }
+
     sf::RenderWindow window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "Arcade Simulator");
-    window.setFramerateLimit(60);
+    window.setFramerateLimit(fpsLimit);
+    window.setKeyRepeatEnabled(false); // a held key is one press, InputState tracks that it's held
+    FixedTimestep timestep(simHz, maxCatchUp);
+
+    // Optionally load everything up front so switching screens never touches the disk
+    // Everything is decoded in the background while the loading screen is up, the menu's assets first.
+    // --preload keeps the loading screen up until all of it is in, otherwise the menu shows as soon as it can
+    AssetCache::instance().setBackgroundSize(window.getSize());
+    AssetCache::instance().loadAsync(MENU_ASSETS);
+    AssetCache::instance().loadAsync(SNAKE_ASSETS);
+    AssetCache::instance().loadAsync(FLAPPY_ASSETS);
+    LoadingScreen loadingScreen(window);
+
+    // Every screen and game is built once and then kept: switching is a push or a pop on the scene
+    // stack, and whatever the player is likely to open next is built ahead of time from the menu
+    SceneManager scenes([&](SceneId id) -> std::unique_ptr<Scene> {
+        switch (id) {
+        case SCENE_SNAKE:
+        case SCENE_FLAPPY: {
+            uint64_t gameSeed = fixedSeed ? seed : entropy();
+            std::unique_ptr<Game> game;
+            if (id == SCENE_SNAKE) {
+                game = std::make_unique<SnakeGame>(window, gameSeed, simHz);
+            }
+            else {
+                game = std::make_unique<FlappyBirdGame>(window, gameSeed, simHz);
+            }
+            if (!recordDir.empty()) {
+                game->recordTo(recordDir);
+            }
+            return game;
+        }
+        case SCENE_INSTRUCTIONS:
+            return std::make_unique<InstructionsScreen>(window);
+        case SCENE_HIGH_SCORES:
+            return std::make_unique<HighScoresScreen>(window);
+        default:
+            return std::make_unique<MainMenu>(window);
+        }
+    });
+    const ProfileState SCENE_STATES[SCENE_COUNT] = { STATE_MENU, STATE_SNAKE, STATE_FLAPPY, STATE_INSTRUCTIONS, STATE_HIGH_SCORES };
+    bool resumable[SCENE_COUNT] = {}; // a game the player left mid-round, picking it again carries on
+
+    auto topGame = [&]() -> Game* {
+        if (scenes.empty() || (scenes.topId() != SCENE_SNAKE && scenes.topId() != SCENE_FLAPPY)) return nullptr;
+        return static_cast<Game*>(&scenes.top());
+    };
 
-    std::unique_ptr<MainMenu> menu = std::make_unique<MainMenu>(window);
-    std::unique_ptr<Game> currentGame;
-    std::unique_ptr<HighScoresScreen> highScoresScreen;
-    std::unique_ptr<InstructionsScreen> instructionsScreen;
+    // Attract mode: left idle on the menu, the autopilot plays snake until a key is pressed
+    bool attract = false;
+    sf::Clock idleClock;
+
+    // Startup timings, printed on exit
+    sf::Clock startupClock;
+    sf::Time firstFrameTime;
+    sf::Time menuReadyTime;
+    bool menuShown = false;
+    bool firstFrameShown = false;
+
+    // Puts a game on top of the menu, recording or replaying it when asked to on the command line
+    auto startGame = [&](GameKind kind, std::shared_ptr<const Replay> playback) {
+        SceneId id = kind == GAME_SNAKE ? SCENE_SNAKE : SCENE_FLAPPY;
+        Game& game = static_cast<Game&>(scenes.get(id));
+        if (playback || !resumable[id]) {
+            game.playBack(std::move(playback));
+            game.reset();
+            if (kind == GAME_SNAKE) {
+                static_cast<SnakeGame&>(game).setAutopilot(autopilot);
+            }
+        }
+        resumable[id] = false;
+        scenes.push(id);
+        timestep.resync();
+    };
+
+    auto endAttract = [&]() {
+        static_cast<SnakeGame&>(scenes.get(SCENE_SNAKE)).setAutopilot(autopilot);
+        scenes.pop();
+        attract = false;
+    };
+
+    // A game asked for while its assets are still decoding waits behind the loading screen
+    int pendingGame = 0; // GameKind, 0 when none
+    std::shared_ptr<const Replay> pendingPlayback;
+    auto requestGame = [&](GameKind kind, std::shared_ptr<const Replay> playback) {
+        pendingGame = kind;
+        pendingPlayback = std::move(playback);
+        scenes.beginSwitch();
+    };
+
+    // Builds the scene the menu selection points at, then the others, one per frame
+    bool assetsTrimmed = false;
+    auto prepareNext = [&]() {
+        const SceneId MENU_TARGETS[] = { SCENE_SNAKE, SCENE_FLAPPY, SCENE_INSTRUCTIONS, SCENE_HIGH_SCORES };
+        const size_t selected = static_cast<size_t>(static_cast<MainMenu&>(scenes.top()).getSelectedItem());
+        AssetCache& assets = AssetCache::instance();
+        for (size_t i = 0; i <= std::size(MENU_TARGETS); ++i) {
+            SceneId id = i == 0 ? (selected < std::size(MENU_TARGETS) ? MENU_TARGETS[selected] : SCENE_MENU) : MENU_TARGETS[i - 1];
+            if (scenes.isBuilt(id)) continue;
+            const std::vector<AssetRef>& needed = id == SCENE_SNAKE ? SNAKE_ASSETS : id == SCENE_FLAPPY ? FLAPPY_ASSETS : MENU_ASSETS;
+            if (!assets.isLoaded(needed)) continue;
+            scenes.prepare(id);
+            return;
+        }
+        // every scene is built and holds what it draws with, whatever only the cache still holds is dropped
+        if (!assetsTrimmed && assets.isIdle()) {
+            assets.releaseUnused();
+            assetsTrimmed = true;
+        }
+    };
 
-    int gameState = 0; 
-    bool showHighScores = false;
-    bool showInstructions = false;
+    // A replay on the command line skips the menu and plays straight away
+    if (replay) {
+        requestGame(replay->game, replay);
+    }
 
     sf::Music bgMusic;
-    if (!bgMusic.openFromFile(BG_MUSIC)) {
+    if (!AssetCache::instance().openMusic(bgMusic, BG_MUSIC)) {
         std::cerr << "Failed to load background music" << std::endl;
     }
     bgMusic.setLoop(true);
     bgMusic.play(); // Function call for background music
 
+    Profiler& profiler = Profiler::instance();
+    ProfilerOverlay profilerOverlay;
+
     while (window.isOpen()) {
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) {
-                window.close();
+        // Move whatever finished decoding into the cache, then start anything that was waiting on it
+        AssetCache& assets = AssetCache::instance();
+        assets.pump();
+        if (scenes.empty() && assets.isLoaded(MENU_ASSETS) && (!preloadAssets || assets.isIdle())) {
+            scenes.push(SCENE_MENU);
+            if (!menuShown) {
+                menuReadyTime = startupClock.getElapsedTime();
+                menuShown = true;
             }
+        }
+        if (pendingGame != 0 && assets.isLoaded(pendingGame == GAME_SNAKE ? SNAKE_ASSETS : FLAPPY_ASSETS)) {
+            startGame(static_cast<GameKind>(pendingGame), pendingPlayback);
+            pendingGame = 0;
+            pendingPlayback.reset();
+        }
+        bool loading = scenes.empty() || pendingGame != 0;
 
-            if (event.type == sf::Event::KeyPressed) {
-                if (gameState != 0 && currentGame && currentGame->isGameOver()) {
-                    if (event.key.code == sf::Keyboard::R) {
-                        currentGame->reset();
+        profiler.setState(loading ? STATE_LOADING : SCENE_STATES[scenes.topId()]);
+        ScopedTimer frameTimer(PROFILE_FRAME);
+
+        {
+            ScopedTimer eventsTimer(PROFILE_EVENTS);
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                InputState::instance().handleEvent(event);
+                if (event.type == sf::Event::Closed) {
+                    window.close();
+                }
+                if (event.type == sf::Event::Resized) {
+                    AssetCache::instance().setBackgroundSize(sf::Vector2u(event.size.width, event.size.height));
+                }
+
+                if (event.type == sf::Event::KeyPressed) {
+                    idleClock.restart();
+                    if (attract) {
+                        // the key only ends the demo, it doesn't also act on the menu
+                        InputState::instance().consumePress(event.key.code);
+                        endAttract();
+                        continue;
+                    }
+                    Game* game = topGame();
+                    if (game && game->isGameOver() && event.key.code == sf::Keyboard::R) {
+                        game->reset();
+                        timestep.resync();
                     }
-                    else if (event.key.code == sf::Keyboard::M) {
-                        currentGame.reset();
-                        gameState = 0;
-                        menu = std::make_unique<MainMenu>(window);
+                    else if (game && event.key.code == sf::Keyboard::M) {
+                        // a round still going is suspended, not thrown away. A replay isn't, picking
+                        // the game from the menu starts a live round
+                        resumable[scenes.topId()] = !game->isGameOver() && !game->isPlayingBack();
+                        scenes.pop();
                     }
                 }
             }
         }
-
-   
-        if (currentGame) {
-            bgMusic.setVolume(currentGame->isMusicMuted() ? 0 : 100);
+        if (InputState::instance().consumePress(sf::Keyboard::F3)) {
+            profilerOverlay.toggle();
+        }
+        loading = loading || scenes.empty(); // M out of a replay started from the command line leaves nothing underneath
+
+        Game* game = loading ? nullptr : topGame();
+        bgMusic.setVolume(game && game->isMusicMuted() ? 0 : 100);
+        // Ticks owed to the running game since the last frame. Time on the menu, loading or paused isn't
+        // owed to anything, so it's forgotten rather than counted against the catch-up limit
+        int ticksDue = 0;
+        if (game && !game->isPaused()) {
+            ticksDue = timestep.beginFrame();
         }
         else {
-            bgMusic.setVolume(100); 
+            timestep.resync();
         }
+
         // function to clear screen 
         window.clear();
 
 
-        if (showHighScores) {
-            if (!highScoresScreen) {
-                highScoresScreen = std::make_unique<HighScoresScreen>(window);
-            }
-            highScoresScreen->handleInput(showHighScores);
-            highScoresScreen->draw();
+        if (loading) {
+            ScopedTimer drawTimer(PROFILE_DRAW);
+            loadingScreen.draw(assets.getProgress());
         }
-        else if (showInstructions) {
-            if (!instructionsScreen) {
-                instructionsScreen = std::make_unique<InstructionsScreen>(window);
+        else {
+            Scene& scene = scenes.top();
+            {
+                ScopedTimer inputTimer(PROFILE_INPUT);
+                scene.handleInput();
+
+                if (scenes.topId() == SCENE_MENU && InputState::instance().consumePress(sf::Keyboard::Enter)) {
+                    int selected = static_cast<MainMenu&>(scene).getSelectedItem();
+                    if (selected == 0) {
+                        requestGame(GAME_SNAKE, nullptr);
+                    }
+                    else if (selected == 1) {
+                        requestGame(GAME_FLAPPY, nullptr);
+                    }
+                    else if (selected == 2) {
+                        scenes.push(SCENE_INSTRUCTIONS);
+                    }
+                    else if (selected == 3) {
+                        scenes.push(SCENE_HIGH_SCORES);
+                    }
+                    else if (selected == 4) {
+                        window.close();
+                    }
+                }
+                if (scene.takeCloseRequest()) {
+                    scenes.pop();
+                }
             }
-            instructionsScreen->handleInput(showInstructions);
-            instructionsScreen->draw();
-        }
-        else if (gameState == 0) {
-            menu->handleInput();
 
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Enter)) {
-                int selected = menu->getSelectedItem();
-                if (selected == 0) {
-                    currentGame = std::make_unique<SnakeGame>(window);
-                    gameState = 1;
+            if (scenes.topId() == SCENE_MENU && pendingGame == 0) {
+                if (idleClock.getElapsedTime().asSeconds() > ATTRACT_IDLE_SECONDS && !resumable[SCENE_SNAKE] && assets.isLoaded(SNAKE_ASSETS)) {
+                    startGame(GAME_SNAKE, nullptr);
+                    static_cast<SnakeGame&>(scenes.top()).setAutopilot(true);
+                    attract = true;
                 }
-                else if (selected == 1) {
-                    currentGame = std::make_unique<FlappyBirdGame>(window);
-                    gameState = 2;
+                else {
+                    prepareNext();
                 }
-                else if (selected == 2) {
-                    showInstructions = true;
+            }
+
+            // whatever is on top now is drawn this frame, so a switch shows on the very next display
+            game = topGame();
+            if (game) {
+                if (attract && game->isGameOver()) {
+                    game->reset(); // the demo just starts over
                 }
-                else if (selected == 3) {
-                    showHighScores = true;
+                if (game->isPaused()) {
+                    timestep.resync(); // a paused round doesn't build up ticks to catch up on
                 }
-                else if (selected == 4) {
-                    window.close();
+                else {
+                    ScopedTimer updateTimer(PROFILE_UPDATE);
+                    for (int tick = 0; tick < ticksDue; ++tick) {
+                        uint64_t allocations = heapAllocations.load(std::memory_order_relaxed);
+                        game->update();
+                        RenderStats::instance().countTick(heapAllocations.load(std::memory_order_relaxed) - allocations, game->isGameOver());
+                    }
                 }
             }
-
-            menu->draw();
-        }
-        else { 
-            if (currentGame) {
-                currentGame->handleInput();
-                currentGame->update();
-                currentGame->draw();
+            ScopedTimer drawTimer(PROFILE_DRAW);
+            if (pendingGame != 0 || scenes.empty()) {
+                loadingScreen.draw(assets.getProgress());
+            }
+            else {
+                scenes.top().draw(timestep.getAlpha());
             }
         }
 
-        window.display();
+        profilerOverlay.draw(window);
+        {
+            ScopedTimer displayTimer(PROFILE_DISPLAY);
+            window.display();
+        }
+        if (!firstFrameShown) {
+            firstFrameTime = startupClock.getElapsedTime();
+            firstFrameShown = true;
+        }
+        scenes.frameShown();
+        RenderStats::instance().endFrame();
+        InputState::instance().endFrame();
     }
 
+    if (!profileOut.empty() && !profiler.writeFile(profileOut)) {
+        std::cerr << "Failed to write profile: " << profileOut << std::endl;
+    }
+    AssetCache::instance().printStats(std::cout);
+    RenderStats::instance().printStats(std::cout);
+    InputState::instance().printStats(std::cout);
+    std::cout << "Startup: first frame after " << firstFrameTime.asMilliseconds() << "ms, menu ready after "
+        << menuReadyTime.asMilliseconds() << "ms" << std::endl;
+    scenes.printStats(std::cout);
+    std::cout << "Simulation: " << timestep.getDroppedTicks() << " ticks dropped by the catch-up limit" << std::endl;
     return 0;
 }